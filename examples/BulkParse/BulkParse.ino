@@ -0,0 +1,124 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+/**
+ *   Bulk parse benchmark. Parses a recorded corpus of search responses (capture.h, in the format written by 
+ *   extras/pcap2replay.py) REPEAT times over, first one datagram at a time through UPnPBuffer into an SSDPResponseSet,
+ *   then with SSDPBulkParser into an SSDPParseTable, and reports the cost per datagram of each. On ESP32 the bulk parse
+ *   is also run with one worker per core. No network is used.
+ */
+
+#include <ssdp.h>
+using namespace lsc;
+
+#ifdef ESP32
+#define BOARD   "ESP32"
+#define WORKERS 2
+#else
+#define BOARD   "ESP8266"
+#define WORKERS 1
+#endif
+
+#define REPEAT       40                   // Times the corpus is parsed over
+#define PACKET_SIZE  1536
+
+typedef struct {
+  unsigned long offset;                   // Milliseconds from the start of the capture
+  uint8_t       addr[4];                  // Source address
+  uint16_t      port;                     // Source port
+  PGM_P         packet;                   // Datagram payload
+} CapturedPacket;
+
+#include "capture.h"
+
+SSDPDatagram*    batch  = NULL;
+int              rows   = 0;
+
+/**
+ *   Copy the corpus out of flash once, and point REPEAT copies of the batch at it
+ */
+boolean loadCorpus() {
+  char** packets = (char**)malloc(CAPTURE_SIZE*sizeof(char*));
+  batch = (SSDPDatagram*)malloc(CAPTURE_SIZE*REPEAT*sizeof(SSDPDatagram));
+  if( (packets == NULL) || (batch == NULL) ) return false;
+  for( int i=0; i<CAPTURE_SIZE; i++ ) {
+    size_t len = strlen_P(capture[i].packet);
+    if( len > PACKET_SIZE ) len = PACKET_SIZE;
+    packets[i] = (char*)malloc(len+1);
+    if( packets[i] == NULL ) return false;
+    memcpy_P(packets[i],capture[i].packet,len);
+    packets[i][len] = '\0';
+  }
+  for( int r=0; r<REPEAT; r++ ) {
+    for( int i=0; i<CAPTURE_SIZE; i++ ) batch[rows++] = {packets[i],strlen(packets[i])};
+  }
+  return true;
+}
+
+void benchUPnPBuffer() {
+  SSDPResponseSet results;
+  unsigned long t0 = micros();
+  for( int i=0; i<rows; i++ ) {
+    UPnPBuffer b(batch[i].data);
+    if( b.isSearchResponse() ) results.add(&b);
+    if( results.dropped() > 0 ) results.clear();
+  }
+  unsigned long cost = micros() - t0;
+  Serial.printf("UPnPBuffer:          %d datagrams in %lu us (%lu ns/datagram)\n",rows,cost,(cost*1000)/rows);
+}
+
+void benchBulk(int workers) {
+  SSDPParseTable table(rows);
+  if( table.capacity() == 0 ) {
+    Serial.printf("Bulk parse:          Not enough memory for %d rows\n",rows);
+    return;
+  }
+  unsigned long t0 = micros();
+  SSDPBulkParser::parse(batch,rows,table,workers);
+  unsigned long cost = micros() - t0;
+  int valid = 0;
+  for( int i=0; i<table.size(); i++ ) if( table.valid(i) ) valid++;
+  Serial.printf("Bulk parse, %d worker%s: %d datagrams in %lu us (%lu ns/datagram), %d valid responses\n",workers,((workers>1)?("s"):("")),
+                                                                     table.size(),cost,(cost*1000)/rows,valid);
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {
+    ; // wait for serial port to connect. Needed for native USB port only
+  }
+
+  Serial.println();
+  Serial.printf("Starting SSDP Bulk Parse Benchmark for Board %s\n",BOARD);
+  if( !loadCorpus() ) {
+    Serial.printf("Not enough memory for the corpus\n");
+    return;
+  }
+
+  benchUPnPBuffer();
+  benchBulk(1);
+  if( WORKERS > 1 ) benchBulk(WORKERS);
+}
+
+void loop() {
+}
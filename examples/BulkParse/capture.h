@@ -0,0 +1,76 @@
+/**
+ *  capture.h - sample corpus for the BulkParse example. Regenerate from a real capture with
+ *  extras/pcap2replay.py
+ */
+
+const char PACKET_0[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.165:80/device\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:b2234c12-417f-4e3c-b5d6-4d418143e85d::urn:LeelanauSoftwareCo-com:device:RootDevice:1\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:SSDP Test:devices:1:services:1:\r\n"
+                                "\r\n";
+const char PACKET_1[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.165:80/device/clock\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:b2234c12-417f-4e3c-b5d6-0a1b2c3d4e5f::urn:LeelanauSoftwareCo-com:device:SoftwareClock:1\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:Clock:services:1:puuid:b2234c12-417f-4e3c-b5d6-4d418143e85d:\r\n"
+                                "\r\n";
+const char PACKET_2[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.165:80/device/getTime\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:urn:LeelanauSoftwareCo-com:service:GetDateTime:1::b2234c12-417f-4e3c-b5d6-4d418143e85d\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:Get Time:puuid:b2234c12-417f-4e3c-b5d6-4d418143e85d:\r\n"
+                                "\r\n";
+const char PACKET_3[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.171:80/device\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:5c3e1f7a-2d4b-4b8e-9c11-0a6f3e2b7d90::urn:LeelanauSoftwareCo-com:device:RootDevice:1\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:Kitchen Clock:devices:1:services:1:\r\n"
+                                "\r\n";
+const char PACKET_4[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.171:80/device/clock\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:5c3e1f7a-2d4b-4b8e-9c11-0a1b2c3d4e5f::urn:LeelanauSoftwareCo-com:device:SoftwareClock:1\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:Clock:services:1:puuid:5c3e1f7a-2d4b-4b8e-9c11-0a6f3e2b7d90:\r\n"
+                                "\r\n";
+const char PACKET_5[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.171:80/device/getTime\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:urn:LeelanauSoftwareCo-com:service:GetDateTime:1::5c3e1f7a-2d4b-4b8e-9c11-0a6f3e2b7d90\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:Get Time:puuid:5c3e1f7a-2d4b-4b8e-9c11-0a6f3e2b7d90:\r\n"
+                                "\r\n";
+const char PACKET_6[] PROGMEM = "HTTP/1.1 200 OK\r\n"
+                                "CACHE-CONTROL: max-age=1800\r\n"
+                                "DATE: Sat, 14 Oct 2023 17:02:11 GMT\r\n"
+                                "EXT:\r\n"
+                                "LOCATION: http://10.0.0.40:8008/ssdp/device-desc.xml\r\n"
+                                "OPT: \"http://schemas.upnp.org/upnp/1/0/\"; ns=01\r\n"
+                                "SERVER: Linux/3.8.13, UPnP/1.0, Portable SDK for UPnP devices/1.6.18\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:3e1cc7c2-f8b1-4a5b-a4a9-7b3c2d1e0f11::upnp:rootdevice\r\n"
+                                "\r\n";
+const char PACKET_7[] PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
+                                "HOST: 239.255.255.250:1900\r\n"
+                                "MAN: ssdp:discover\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "ST.LEELANAUSOFTWARE.COM: ssdp:all\r\n"
+                                "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n"
+                                "\r\n";
+
+CapturedPacket capture[] = {
+  {0,    {10,0,0,165}, 1900,  PACKET_0},
+  {12,   {10,0,0,165}, 1900,  PACKET_1},
+  {24,   {10,0,0,165}, 1900,  PACKET_2},
+  {31,   {10,0,0,171}, 1900,  PACKET_3},
+  {43,   {10,0,0,171}, 1900,  PACKET_4},
+  {55,   {10,0,0,171}, 1900,  PACKET_5},
+  {210,  {10,0,0,40},  1900,  PACKET_6},
+  {1200, {10,0,0,12},  50000, PACKET_7},
+};
+const int CAPTURE_SIZE = 8;
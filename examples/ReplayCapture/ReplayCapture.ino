@@ -0,0 +1,172 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *   Replay captured SSDP traffic through the responder and client code paths and report per packet processing cost.
+ *   Record port 1900 traffic with tcpdump and convert it to capture.h with extras/pcap2replay.py. Responses are handed
+ *   to a send handler rather than the network, so the sketch reports exactly what the responder would have sent.
+ */
+
+#include <ssdp.h>
+using namespace lsc;
+
+#define AP_SSID "My_SSID"
+#define AP_PSK  "MY_PSK"
+#define SERVER_PORT 80
+
+/**
+ *   TIME_SCALE controls replay timing: 0 replays as fast as possible, 1 replays at original timing, and N > 1
+ *   compresses the original timing N times.
+ */
+#define TIME_SCALE  0
+#define PACKET_SIZE 1536
+#define OUTPUT_SIZE 4096                  // Responses to one packet held for printing after it is timed
+
+#include <ESP8266WiFi.h>
+ESP8266WebServer  server(SERVER_PORT);
+#define           BOARD "ESP8266"
+
+typedef struct {
+  unsigned long offset;                   // Milliseconds from the start of the capture
+  uint8_t       addr[4];                  // Source address
+  uint16_t      port;                     // Source port
+  PGM_P         packet;                   // Datagram payload
+} CapturedPacket;
+
+#include "capture.h"
+
+WebContext       ctx;
+RootDevice       root;
+SSDP             ssdp;
+
+int              responses     = 0;
+int              responseBytes = 0;
+char             output[OUTPUT_SIZE];
+size_t           outputLen     = 0;
+
+void replayCapture() {
+  char          packet[PACKET_SIZE];
+  char          st[100];
+  unsigned long totalMicros = 0;
+  unsigned long start       = millis();
+
+  for( int i=0; i<CAPTURE_SIZE; i++ ) {
+#if TIME_SCALE > 0
+    unsigned long due = start + capture[i].offset/TIME_SCALE;
+    while( (long)(due - millis()) > 0 ) {delay(1);}
+#endif
+    strncpy_P(packet,capture[i].packet,PACKET_SIZE-1);
+    packet[PACKET_SIZE-1] = '\0';
+    IPAddress remote(capture[i].addr[0],capture[i].addr[1],capture[i].addr[2],capture[i].addr[3]);
+    int sent = responses;
+
+    unsigned long t0 = micros();
+    boolean handled = false;
+    UPnPBuffer b(packet);
+    if( b.isSearchRequest() ) handled = ssdp.replay(packet,remote,capture[i].port);
+    else if( b.headerValue("ST",st,100) ) handled = SSDP::replayResponse(packet,st,[](UPnPBuffer* b){});
+    unsigned long cost = micros() - t0;
+    totalMicros += cost;
+
+    Serial.printf("Packet %d from %s:%d %s in %lu us, %d responses\n",i,remote.toString().c_str(),capture[i].port,
+                                                                      (handled?"handled":"ignored"),cost,responses-sent);
+    Serial.print(output);
+    if( outputLen == OUTPUT_SIZE - 1 ) Serial.printf("   ... output truncated\n");
+    outputLen = 0;
+    output[0] = '\0';
+  }
+  Serial.printf("Replayed %d packets in %lu us (%lu us/packet), %d responses, %d bytes\n",CAPTURE_SIZE,totalMicros,
+                                                     ((CAPTURE_SIZE>0)?(totalMicros/CAPTURE_SIZE):(0)),responses,responseBytes);
+}
+
+/**
+ *   The same service sent as a text response and as a compact response must produce the same record
+ */
+const char SERVICE_TEXT[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                    "CACHE-CONTROL: max-age = 1800 \r\n"
+                                    "LOCATION: http://10.0.0.165:80/device/getTime\r\n"
+                                    "ST: upnp:rootdevice\r\n"
+                                    "USN: uuid:urn:LeelanauSoftwareCo-com:service:GetDateTime:1::b2234c12-417f-4e3c-b5d6-4d418143e85d\r\n"
+                                    "DESC.LEELANAUSOFTWARE.COM: :name:Get Time:puuid:b2234c12-417f-4e3c-b5d6-4d418143e85d:\r\n"
+                                    "\r\n";
+
+boolean checkEncodings() {
+  char              packet[PACKET_SIZE];
+  uint8_t           compact[PACKET_SIZE];
+  SSDPResponseSet   results(2048,16);
+  IPAddress         remote(10,0,0,165);
+  SSDPCompactFields f = {SSDP_SERVICE_RECORD,"b2234c12-417f-4e3c-b5d6-4d418143e85d","b2234c12-417f-4e3c-b5d6-4d418143e85d",
+                         "urn:LeelanauSoftwareCo-com:service:GetDateTime:1","upnp:rootdevice","Get Time",
+                         "http://10.0.0.165:80/device/getTime",0,0};
+  strncpy_P(packet,SERVICE_TEXT,PACKET_SIZE-1);
+  packet[PACKET_SIZE-1] = '\0';
+  UPnPBuffer b(packet);
+  SSDPRecord* text = results.add(&b);
+  size_t len = SSDPCompact::encode(compact,PACKET_SIZE,f,remote);
+  SSDPRecord* bin  = SSDPCompact::decode(compact,len,remote,"upnp:rootdevice",results);
+  boolean result = (text != NULL) && (bin != NULL) && (text->kind == bin->kind) && (text->uuid == bin->uuid) && 
+                   (text->type == bin->type) && (text->puuid == bin->puuid) && (strcmp(text->name,bin->name) == 0) && 
+                   (strcmp(text->location,bin->location) == 0);
+  Serial.printf("Text and compact service records %s\n",((result)?("match"):("DIFFER")));
+  return result;
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {
+    ; // wait for serial port to connect. Needed for native USB port only
+  }
+
+  Serial.println();
+  Serial.printf("Starting SSDP Replay for Board %s\n",BOARD);
+
+  WiFi.begin(AP_SSID,AP_PSK);
+  Serial.printf("Connecting to Access Point %s\n",AP_SSID);
+  while(WiFi.status() != WL_CONNECTED) {Serial.print(".");delay(500);}
+
+  Serial.printf("\nWiFi Connected to %s with IP address: %s\n",WiFi.SSID().c_str(),
+                                                              WiFi.localIP().toString().c_str());
+  server.begin();
+  ctx.setup(&server,WiFi.localIP(),SERVER_PORT);
+
+  root.setDisplayName("SSDP Replay");
+  root.setTarget("device");  
+  root.setup(&ctx);
+  ssdp.begin(&root);
+
+/**
+ *   Hand responses to the sketch instead of the network. They are collected and printed after each packet is timed,
+ *   so the time reported is the responder's and not the serial port's.
+ */
+  ssdp.setSendHandler([](const char* packet, int len, IPAddress remoteAddr, int port) {
+     responses++;
+     responseBytes += len;
+     int n = snprintf(output+outputLen,OUTPUT_SIZE-outputLen,"   -> %s:%d (%d bytes)\n%.*s",remoteAddr.toString().c_str(),port,len,len,packet);
+     if( n > 0 ) outputLen = ((outputLen + n < OUTPUT_SIZE)?(outputLen + n):(OUTPUT_SIZE - 1));
+  });
+
+  checkEncodings();
+  replayCapture();
+}
+
+void loop() {
+}
@@ -0,0 +1,49 @@
+/**
+ *  capture.h - sample capture for the ReplayCapture example. Regenerate from a real capture with
+ *  extras/pcap2replay.py
+ */
+
+const char PACKET_0[] PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
+                                "HOST: 239.255.255.250:1900\r\n"
+                                "MAN: ssdp:discover\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "ST.LEELANAUSOFTWARE.COM: \r\n"
+                                "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n"
+                                "\r\n";
+const char PACKET_1[] PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
+                                "HOST: 239.255.255.250:1900\r\n"
+                                "MAN: \"ssdp:discover\"\r\n"
+                                "MX: 2\r\n"
+                                "ST: urn:dial-multiscreen-org:service:dial:1\r\n"
+                                "USER-AGENT: Google Chrome/118.0 Windows\r\n"
+                                "\r\n";
+const char PACKET_2[] PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
+                                "HOST: 239.255.255.250:1900\r\n"
+                                "MAN: ssdp:discover\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "ST.LEELANAUSOFTWARE.COM: ssdp:all\r\n"
+                                "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n"
+                                "\r\n";
+const char PACKET_3[] PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                "CACHE-CONTROL: max-age = 1800 \r\n"
+                                "LOCATION: http://10.0.0.165:80/device\r\n"
+                                "ST: upnp:rootdevice\r\n"
+                                "USN: uuid:b2234c12-417f-4e3c-b5d6-4d418143e85d::urn:LeelanauSoftwareCo-com:device:RootDevice:1\r\n"
+                                "DESC.LEELANAUSOFTWARE.COM: :name:SSDP Test:devices:0:services:0:\r\n"
+                                "\r\n";
+const char PACKET_4[] PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
+                                "HOST: 239.255.255.250:1900\r\n"
+                                "MAN: ssdp:discover\r\n"
+                                "ST: urn:LeelanauSoftwareCo-com:device:RootDevice:1\r\n"
+                                "ST.LEELANAUSOFTWARE.COM: ssdp:all\r\n"
+                                "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n"
+                                "\r\n";
+
+CapturedPacket capture[] = {
+  {0,    {10,0,0,12},  50000, PACKET_0},
+  {35,   {10,0,0,40},  61544, PACKET_1},
+  {1210, {10,0,0,12},  50001, PACKET_2},
+  {1740, {10,0,0,165}, 1900,  PACKET_3},
+  {2305, {10,0,0,12},  50002, PACKET_4},
+};
+const int CAPTURE_SIZE = 5;
@@ -0,0 +1,156 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+/**
+ *   SSDP load probe. Sends a weighted mix of search requests at a target rate, either to the multicast group or to a 
+ *   single device, matches responses to the request that produced them, and reports throughput, loss and response
+ *   latency percentiles for each request class.
+ *   
+ *   Configure the request mix in probeClasses[]. expected is the number of responses each search of that class should 
+ *   produce on the bench network (for example the number of boards, or the size of a root's device tree for ssdp:all); 
+ *   a search receiving fewer is counted as lossy and the missing responses are counted as lost.
+ *
+ *   Searches are sent one at a time (closed loop): each search blocks until no response has arrived for SEARCH_WINDOW
+ *   milliseconds, so SEARCH_RATE is an upper bound. A search that runs past its interval delays the next one, and the
+ *   report gives the rate actually achieved and the number of searches that overran.
+ */
+
+#include <ssdp.h>
+#include <ESP8266WiFi.h>
+
+using namespace lsc;
+#define AP_SSID "My_SSID"
+#define AP_PSK  "MY_PSK"
+#define BOARD "ESP8266"
+
+#define SEARCH_RATE    2                     // Target searches per second, an upper bound
+#define SEARCH_WINDOW  300                   // Milliseconds without a response that end each search
+#define PROBE_COUNT    200                   // Number of searches to send
+#define MAX_SAMPLES    256                   // Latency samples kept per class
+#define TARGET         IPAddress(0,0,0,0)    // Set to a device address for unicast probing, otherwise multicast
+
+typedef struct {
+  const char*     label;
+  const char*     st;
+  boolean         ssdpAll;
+  int             weight;                    // Relative share of the request mix
+  int             expected;                  // Responses expected per search
+  int             searches;
+  int             responses;
+  int             lost;
+  int             samples;
+  unsigned long   latency[MAX_SAMPLES];      // Milliseconds from send to response
+} ProbeClass;
+
+ProbeClass probeClasses[] = {
+  {"rootdevice",          "upnp:rootdevice",                                  false, 4, 1},
+  {"rootdevice+all",      "upnp:rootdevice",                                  true,  1, 3},
+  {"uuid",                "uuid:b2234c12-417f-4e3c-b5d6-4d418143e85d",        false, 2, 1},
+  {"urn",                 "urn:LEELANAUSOFTWARE-com:device:SoftwareClock:1",  false, 2, 1},
+};
+const int NUM_CLASSES = sizeof(probeClasses)/sizeof(ProbeClass);
+int       overruns    = 0;                   // Searches that ran past their interval
+
+static_assert(SEARCH_WINDOW < 1000/SEARCH_RATE, "SEARCH_WINDOW must be shorter than the search interval");
+
+ProbeClass* nextClass(int n) {
+  int total = 0;
+  for( int i=0; i<NUM_CLASSES; i++ ) total += probeClasses[i].weight;
+  int slot = n % total;
+  for( int i=0; i<NUM_CLASSES; i++ ) {
+    if( slot < probeClasses[i].weight ) return &probeClasses[i];
+    slot -= probeClasses[i].weight;
+  }
+  return &probeClasses[0];
+}
+
+int compareLatency(const void* a, const void* b) {
+  unsigned long x = *(const unsigned long*)a;
+  unsigned long y = *(const unsigned long*)b;
+  return (x<y)?(-1):((x>y)?(1):(0));
+}
+
+unsigned long percentile(ProbeClass* c, int pct) {
+  if( c->samples == 0 ) return 0;
+  int index = (c->samples * pct)/100;
+  if( index >= c->samples ) index = c->samples - 1;
+  return c->latency[index];
+}
+
+void report(unsigned long elapsed) {
+  Serial.printf("\nProbe complete in %lu ms, %.2f searches/s (target %d), %d searches overran their interval\n",elapsed,
+                ((elapsed>0)?(1000.0*PROBE_COUNT/elapsed):(0.0)),SEARCH_RATE,overruns);
+  Serial.printf("%-16s %8s %9s %6s %8s %6s %6s %6s %6s\n","class","searches","responses","lost","resp/s","p50","p90","p99","max");
+  for( int i=0; i<NUM_CLASSES; i++ ) {
+    ProbeClass* c = &probeClasses[i];
+    qsort(c->latency,c->samples,sizeof(unsigned long),compareLatency);
+    float rate = ((elapsed>0)?(1000.0*c->responses/elapsed):(0.0));
+    Serial.printf("%-16s %8d %9d %6d %8.2f %6lu %6lu %6lu %6lu\n",c->label,c->searches,c->responses,c->lost,rate,
+                  percentile(c,50),percentile(c,90),percentile(c,99),percentile(c,100));
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) {
+    ; // wait for serial port to connect. Needed for native USB port only
+  }
+
+  Serial.println();
+  Serial.printf("Starting SSDP Probe for Board %s\n",BOARD);
+
+  WiFi.begin(AP_SSID,AP_PSK);
+  Serial.printf("Connecting to Access Point %s\n",AP_SSID);
+  while(WiFi.status() != WL_CONNECTED) {Serial.print(".");delay(500);}
+
+  Serial.printf("\nWiFi Connected to %s with IP address: %s\n",WiFi.SSID().c_str(),
+                                                           WiFi.localIP().toString().c_str());
+
+  IPAddress     target   = TARGET;
+  unsigned long interval = 1000/SEARCH_RATE;
+  unsigned long start    = millis();
+  for( int n=0; n<PROBE_COUNT; n++ ) {
+    ProbeClass*   c      = nextClass(n);
+    unsigned long sent   = millis();
+    int           count  = 0;
+    SSDPHandler   handler = [c,sent,&count](UPnPBuffer* b) {
+      count++;
+      c->responses++;
+      if( c->samples < MAX_SAMPLES ) c->latency[c->samples++] = millis() - sent;
+    };
+    c->searches++;
+    if( target == IPAddress(0,0,0,0) ) SSDP::searchRequest(c->st,handler,WiFi.localIP(),SEARCH_WINDOW,c->ssdpAll);
+    else SSDP::unicastSearchRequest(c->st,handler,WiFi.localIP(),target,SEARCH_WINDOW,c->ssdpAll);
+    if( count < c->expected ) c->lost += c->expected - count;
+
+/**
+ *  Hold the target rate; if a search window overruns the interval the next search is sent immediately
+ */
+    unsigned long due = start + (n+1)*interval;
+    if( (long)(due - millis()) < 0 ) overruns++;
+    while( (long)(due - millis()) > 0 ) {delay(1);}
+  }
+  report(millis() - start);
+}
+
+void loop() {
+}
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+#
+#  ssdp Library
+#  Copyright (C) 2023  Daniel L Toth
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU Lesser General Public License as published
+#  by the Free Software Foundation, either version 3 of the License, or any
+#  later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU Lesser General Public License for more details.
+#
+#  You should have received a copy of the GNU Lesser General Public License
+#  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+#
+#  The author can be contacted at dan@leelanausoftware.com
+#
+
+"""
+pcap2replay.py
+
+Convert a capture of SSDP traffic into a capture.h header for the ReplayCapture example.
+
+Record port 1900 traffic on the LAN with, for example:
+
+    tcpdump -i eth0 -w capture.pcap udp port 1900
+
+and then convert it with:
+
+    python3 pcap2replay.py capture.pcap > ../examples/ReplayCapture/capture.h
+
+Only classic pcap files with Ethernet, Linux cooked or raw IPv4 link types are read. Datagrams are emitted with their
+offset in milliseconds from the first packet, source address and port, and payload.
+"""
+
+import struct
+import sys
+
+LINKTYPE_ETHERNET = 1
+LINKTYPE_RAW      = 101
+LINKTYPE_LINUX_SLL = 113
+SSDP_PORT         = 1900
+
+
+def read_pcap(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    magic = data[:4]
+    if magic in (b"\xd4\xc3\xb2\xa1", b"\x4d\x3c\xb2\xa1"):
+        endian = "<"
+    elif magic in (b"\xa1\xb2\xc3\xd4", b"\xa1\xb2\x3c\x4d"):
+        endian = ">"
+    else:
+        raise ValueError("%s is not a classic pcap file" % path)
+    nanos = magic in (b"\x4d\x3c\xb2\xa1", b"\xa1\xb2\x3c\x4d")
+    linktype = struct.unpack(endian + "I", data[20:24])[0]
+    pos = 24
+    while pos + 16 <= len(data):
+        sec, frac, incl, _ = struct.unpack(endian + "IIII", data[pos:pos + 16])
+        pos += 16
+        frame = data[pos:pos + incl]
+        pos += incl
+        usec = frac // 1000 if nanos else frac
+        yield sec * 1000000 + usec, linktype, frame
+
+
+def ipv4_payload(linktype, frame):
+    if linktype == LINKTYPE_ETHERNET:
+        ethertype = struct.unpack("!H", frame[12:14])[0]
+        offset = 14
+        if ethertype == 0x8100:
+            ethertype = struct.unpack("!H", frame[16:18])[0]
+            offset = 18
+        return frame[offset:] if ethertype == 0x0800 else None
+    if linktype == LINKTYPE_LINUX_SLL:
+        return frame[16:] if struct.unpack("!H", frame[14:16])[0] == 0x0800 else None
+    if linktype == LINKTYPE_RAW:
+        return frame
+    return None
+
+
+def ssdp_datagrams(path):
+    for usec, linktype, frame in read_pcap(path):
+        ip = ipv4_payload(linktype, frame)
+        if ip is None or len(ip) < 20 or (ip[0] >> 4) != 4 or ip[9] != 17:
+            continue
+        ihl = (ip[0] & 0x0f) * 4
+        sport, dport, ulen = struct.unpack("!HHH", ip[ihl:ihl + 6])
+        if SSDP_PORT not in (sport, dport):
+            continue
+        payload = ip[ihl + 8:ihl + ulen]
+        yield usec, ip[12:16], sport, payload
+
+
+def c_string(payload):
+    out = []
+    for line in payload.decode("latin-1").split("\n"):
+        escaped = line.replace("\\", "\\\\").replace("\"", "\\\"").replace("\r", "\\r")
+        out.append(escaped)
+    text = "\\n\"\n                                \"".join(out)
+    return "\"" + text + "\""
+
+
+def main(argv):
+    if len(argv) != 2:
+        sys.stderr.write("usage: pcap2replay.py capture.pcap > capture.h\n")
+        return 1
+    packets = list(ssdp_datagrams(argv[1]))
+    start = packets[0][0] if packets else 0
+    print("/**")
+    print(" *  capture.h - generated by extras/pcap2replay.py from %s" % argv[1])
+    print(" */")
+    print()
+    for i, (_, _, _, payload) in enumerate(packets):
+        print("const char PACKET_%d[] PROGMEM = %s;" % (i, c_string(payload)))
+    print()
+    print("CapturedPacket capture[] = {")
+    for i, (usec, addr, port, _) in enumerate(packets):
+        print("  {%d, {%d,%d,%d,%d}, %d, PACKET_%d}," % ((usec - start) // 1000, addr[0], addr[1], addr[2], addr[3], port, i))
+    print("};")
+    print("const int CAPTURE_SIZE = %d;" % len(packets))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
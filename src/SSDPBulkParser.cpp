@@ -0,0 +1,277 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#include "SSDPBulkParser.h"
+#include "SSDPHeaders.h"
+
+#if SSDP_CLIENT
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#endif
+
+namespace lsc {
+
+#define BULK_MAX_DATAGRAM  0xFFFF            // Spans are 16 bit, longer datagrams are parsed up to this length
+#define BULK_TASK_STACK    2048
+
+const char BULK_RESPONSE_LINE[]  PROGMEM = "HTTP/1.1";
+const char BULK_ST_HEADER[]      PROGMEM = "ST";
+const char BULK_USN_HEADER[]     PROGMEM = "USN";
+const char BULK_LOCATION_HEADER[] PROGMEM = "LOCATION";
+const char BULK_UUID_PREFIX[]    PROGMEM = "uuid:";
+const char BULK_NAME_FIELD[]     PROGMEM = "name";
+const char BULK_PUUID_FIELD[]    PROGMEM = "puuid";
+const char BULK_DEVICES_FIELD[]  PROGMEM = "devices";
+const char BULK_SERVICES_FIELD[] PROGMEM = "services";
+
+SSDPParseTable::SSDPParseTable(int capacity) {
+  for( int c=0; c<SSDP_COLUMNS; c++ ) _columns[c] = NULL;
+  if( capacity <= 0 ) return;
+
+/**
+ *  Span columns come first so they are aligned, followed by the byte columns
+ */
+  size_t spans = capacity * sizeof(SSDPSpan);
+  _block = (uint8_t*)malloc(SSDP_COLUMNS*spans + 4*capacity);
+  if( _block == NULL ) return;
+  for( int c=0; c<SSDP_COLUMNS; c++ ) _columns[c] = (SSDPSpan*)(_block + c*spans);
+  uint8_t* bytes = _block + SSDP_COLUMNS*spans;
+  _flags       = bytes;
+  _kinds       = bytes + capacity;
+  _numDevices  = bytes + 2*capacity;
+  _numServices = bytes + 3*capacity;
+  _capacity    = capacity;
+}
+
+SSDPParseTable::~SSDPParseTable() {
+  if( _block != NULL ) free(_block);
+}
+
+size_t SSDPParseTable::copy(const SSDPDatagram& d, int row, SSDPColumn c, char buffer[], size_t size) const {
+  size_t result = 0;
+  if( size == 0 ) return result;
+  buffer[0] = '\0';
+  const SSDPSpan* col = column(c);
+  if( (col != NULL) && (row >= 0) && (row < _size) ) {
+    result = col[row].len;
+    if( result > size - 1 ) result = size - 1;
+    memcpy(buffer,d.data + col[row].offset,result);
+    buffer[result] = '\0';
+  }
+  return result;
+}
+
+#if defined(ESP32)
+/**
+ *  A range of the batch parsed by a worker task: count datagrams starting at batch into rows starting at row
+ */
+typedef struct BulkWork {
+  const SSDPDatagram* batch;
+  SSDPParseTable*     table;
+  int                 row;
+  int                 count;
+  SemaphoreHandle_t   done;
+} BulkWork;
+#endif
+
+/**
+ *  Rows are split into workers contiguous ranges. Each range writes only its own rows, so workers share nothing but
+ *  the (read only) batch. The caller parses the first range, and each other range runs in a task pinned to the next
+ *  core after the caller's, so no worker shares a core with the caller.
+ */
+int SSDPBulkParser::parse(const SSDPDatagram batch[], int count, SSDPParseTable& table, int workers) {
+  int first = table._size;
+  if( count > table._capacity - first ) count = table._capacity - first;
+  if( count <= 0 ) return 0;
+
+#if defined(ESP32)
+  if( workers > portNUM_PROCESSORS ) workers = portNUM_PROCESSORS;
+  if( workers > count ) workers = count;
+  SemaphoreHandle_t done = ((workers > 1)?(xSemaphoreCreateCounting(workers,0)):(NULL));
+  if( done != NULL ) {
+    BulkWork work[portNUM_PROCESSORS];
+    int per     = (count + workers - 1)/workers;
+    int started = 0;
+    int core    = xPortGetCoreID();
+    for( int i=1; i<workers; i++ ) {
+      int from = i*per;
+      int to   = (((i+1)*per < count)?((i+1)*per):(count));
+      if( from >= to ) continue;
+      work[i] = {batch + from,&table,first + from,to - from,done};
+      if( xTaskCreatePinnedToCore(task,"ssdpBulk",BULK_TASK_STACK,&work[i],uxTaskPriorityGet(NULL),NULL,(core + i) % portNUM_PROCESSORS) == pdPASS ) started++;
+      else parse(batch + from,table,first + from,to - from);
+    }
+    parse(batch,table,first,per);
+    for( int i=0; i<started; i++ ) xSemaphoreTake(done,portMAX_DELAY);
+    vSemaphoreDelete(done);
+    table._size = first + count;
+    return count;
+  }
+#else
+  (void)workers;
+#endif
+
+  parse(batch,table,first,count);
+  table._size = first + count;
+  return count;
+}
+
+#if defined(ESP32)
+void SSDPBulkParser::task(void* arg) {
+  BulkWork* w = (BulkWork*)arg;
+  parse(w->batch,*w->table,w->row,w->count);
+  xSemaphoreGive(w->done);
+  vTaskDelete(NULL);
+}
+#endif
+
+void SSDPBulkParser::parse(const SSDPDatagram batch[], SSDPParseTable& table, int row, int count) {
+  for( int i=0; i<count; i++ ) parse(batch[i],table,row + i);
+}
+
+/**
+ *  Return the end of the line starting at p, the '\r' of its "\r\n", or NULL if the line is not terminated before end
+ */
+static const char* lineEnd(const char* p, const char* end) {
+  while( p < end ) {
+    const char* cr = (const char*)memchr(p,'\r',end - p);
+    if( (cr == NULL) || (cr + 1 >= end) ) return NULL;
+    if( cr[1] == '\n' ) return cr;
+    p = cr + 1;
+  }
+  return NULL;
+}
+
+static boolean isHeader(const char* name, size_t len, PGM_P header) {
+  return (len == strlen_P(header)) && (strncasecmp_P(name,header,len) == 0);
+}
+
+static SSDPSpan span(const char* base, const char* start, const char* end) {
+  SSDPSpan result = {(uint16_t)(start - base),(uint16_t)(end - start)};
+  return result;
+}
+
+static int number(const char* p, const char* end) {
+  int result = 0;
+  while( (p < end) && isdigit(*p) ) result = 10*result + (*p++ - '0');
+  return result;
+}
+
+/**
+ *  The line parser. Header names are matched by length first, so most lines are rejected without a compare.
+ */
+uint8_t SSDPBulkParser::parse(const SSDPDatagram& d, SSDPParseTable& table, int row) {
+  const char* base = d.data;
+  const char* end  = d.data + ((d.len > BULK_MAX_DATAGRAM)?(BULK_MAX_DATAGRAM):(d.len));
+  uint8_t     flags = 0;
+  SSDPSpan    empty = {0,0};
+  for( int c=0; c<SSDP_COLUMNS; c++ ) table._columns[c][row] = empty;
+  table._kinds[row]       = SSDP_ROOT_RECORD;
+  table._numDevices[row]  = 0;
+  table._numServices[row] = 0;
+
+  const char* eol = lineEnd(base,end);
+  if( (end - base >= 8) && (strncmp_P(base,BULK_RESPONSE_LINE,8) == 0) ) flags |= SSDP_ROW_RESPONSE;
+  if( (flags & SSDP_ROW_RESPONSE) && (eol == NULL) ) flags |= SSDP_ROW_TRUNCATED;
+
+  const char* p = ((flags & SSDP_ROW_RESPONSE) && (eol != NULL)?(eol + 2):(end));
+  while( p < end ) {
+    eol = lineEnd(p,end);
+    if( eol == NULL ) {flags |= SSDP_ROW_TRUNCATED; break;}
+    if( eol == p ) break;
+    const char* colon = (const char*)memchr(p,':',eol - p);
+    if( colon != NULL ) {
+      const char* nameEnd = colon;
+      while( (nameEnd > p) && (nameEnd[-1] == ' ') ) nameEnd--;
+      const char* value = colon + 1;
+      while( (value < eol) && (*value == ' ') ) value++;
+      const char* valueEnd = eol;
+      while( (valueEnd > value) && (valueEnd[-1] == ' ') ) valueEnd--;
+      size_t nameLen = nameEnd - p;
+
+      if( (nameLen == 2) && isHeader(p,nameLen,BULK_ST_HEADER) ) {
+        table._columns[SSDP_COL_ST][row] = span(base,value,valueEnd);
+        flags |= SSDP_ROW_ST;
+      }
+      else if( (nameLen == 3) && isHeader(p,nameLen,BULK_USN_HEADER) && (valueEnd - value >= 5) && (strncmp_P(value,BULK_UUID_PREFIX,5) == 0) ) {
+        const char* uuid;
+        const char* type;
+        size_t      uuidLen, typeLen;
+        UPnPBuffer::splitUSN(value,valueEnd - value,&uuid,&uuidLen,&type,&typeLen);
+        table._columns[SSDP_COL_UUID][row] = span(base,uuid,uuid + uuidLen);
+        if( typeLen > 0 ) table._columns[SSDP_COL_TYPE][row] = span(base,type,type + typeLen);
+        flags |= SSDP_ROW_USN;
+      }
+      else if( (nameLen == 8) && isHeader(p,nameLen,BULK_LOCATION_HEADER) ) {
+        table._columns[SSDP_COL_LOCATION][row] = span(base,value,valueEnd);
+        flags |= SSDP_ROW_LOCATION;
+      }
+      else if( (nameLen == 25) && isHeader(p,nameLen,DESC_LSC_HEADER) ) {
+        parseDesc(base,value,valueEnd,table,row);
+        if( table._columns[SSDP_COL_NAME][row].len > 0 ) flags |= SSDP_ROW_DESC;
+      }
+    }
+    p = eol + 2;
+  }
+  table._flags[row] = flags;
+  return flags;
+}
+
+/**
+ *  DESC is a list of :key:value: pairs. The kind of node follows from the fields present, as in SSDPResponseSet: no
+ *  puuid is a RootDevice, puuid with services is an embedded device, and puuid alone is a service.
+ */
+void SSDPBulkParser::parseDesc(const char* base, const char* value, const char* end, SSDPParseTable& table, int row) {
+  boolean hasPuuid    = false;
+  boolean hasServices = false;
+  const char* p = value;
+  if( (p < end) && (*p == ':') ) p++;
+  while( p < end ) {
+    const char* key    = p;
+    const char* keyEnd = (const char*)memchr(key,':',end - key);
+    if( keyEnd == NULL ) break;
+    const char* field    = keyEnd + 1;
+    const char* fieldEnd = (const char*)memchr(field,':',end - field);
+    if( fieldEnd == NULL ) fieldEnd = end;
+    size_t keyLen = keyEnd - key;
+    if( isHeader(key,keyLen,BULK_NAME_FIELD) )          table._columns[SSDP_COL_NAME][row] = span(base,field,fieldEnd);
+    else if( isHeader(key,keyLen,BULK_PUUID_FIELD) ) {
+      table._columns[SSDP_COL_PUUID][row] = span(base,field,fieldEnd);
+      hasPuuid = true;
+    }
+    else if( isHeader(key,keyLen,BULK_DEVICES_FIELD) )  table._numDevices[row] = number(field,fieldEnd);
+    else if( isHeader(key,keyLen,BULK_SERVICES_FIELD) ) {
+      table._numServices[row] = number(field,fieldEnd);
+      hasServices = true;
+    }
+    p = fieldEnd + 1;
+  }
+  table._kinds[row] = ((!hasPuuid)?(SSDP_ROOT_RECORD):((hasServices)?(SSDP_DEVICE_RECORD):(SSDP_SERVICE_RECORD)));
+}
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,138 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPBULKPARSER_H
+#define SSDPBULKPARSER_H
+
+#include <Arduino.h>
+#include "SSDPConfig.h"
+#include "SSDPResponseSet.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  A captured datagram. data need not be null terminated, parsing stops at len bytes.
+ */
+typedef struct SSDPDatagram {
+  const char*     data;
+  size_t          len;
+} SSDPDatagram;
+
+/**
+ *  Part of a datagram, as an offset and length into its data. Spans are not copied, so they are valid as long as the
+ *  datagrams are. An absent field has length 0.
+ */
+typedef struct SSDPSpan {
+  uint16_t        offset;
+  uint16_t        len;
+} SSDPSpan;
+
+/**
+ *  Text columns of an SSDPParseTable. uuid and type are split from USN as in SSDPResponseSet; name and puuid are 
+ *  fields of DESC.LEELANAUSOFTWARE.COM.
+ */
+typedef enum {
+  SSDP_COL_ST       = 0,
+  SSDP_COL_UUID     = 1,
+  SSDP_COL_TYPE     = 2,
+  SSDP_COL_LOCATION = 3,
+  SSDP_COL_NAME     = 4,
+  SSDP_COL_PUUID    = 5,
+  SSDP_COLUMNS      = 6
+} SSDPColumn;
+
+/**
+ *  Row flags. A row is an LSC search response if every flag of SSDP_ROW_VALID is set.
+ */
+#define SSDP_ROW_RESPONSE   0x01           // Start line is HTTP/1.1
+#define SSDP_ROW_ST         0x02           // ST header present
+#define SSDP_ROW_USN        0x04           // USN header present with a uuid: prefix
+#define SSDP_ROW_LOCATION   0x08           // LOCATION header present
+#define SSDP_ROW_DESC       0x10           // DESC.LEELANAUSOFTWARE.COM header present with a name
+#define SSDP_ROW_TRUNCATED  0x20           // Datagram ends before the blank line that ends its headers
+#define SSDP_ROW_VALID      (SSDP_ROW_RESPONSE | SSDP_ROW_ST | SSDP_ROW_USN | SSDP_ROW_LOCATION | SSDP_ROW_DESC)
+
+/**
+ *  Structure of arrays result table of SSDPBulkParser, one row per datagram. Each field is held in its own column, so
+ *  a pass over one field of every row (kinds, or uuids) reads contiguous memory. The columns are allocated as a single
+ *  block on construction; capacity() is 0 if the allocation failed.
+ */
+class SSDPParseTable {
+  public:
+    SSDPParseTable(int capacity);
+    ~SSDPParseTable();
+
+    int               capacity()                  const   {return _capacity;}
+    int               size()                      const   {return _size;}
+    void              clear()                             {_size = 0;}
+    boolean           valid(int row)              const   {return (_flags[row] & SSDP_ROW_VALID) == SSDP_ROW_VALID;}
+
+    const uint8_t*    flags()                     const   {return _flags;}
+    const uint8_t*    kinds()                     const   {return _kinds;}          // SSDPRecordKind of each row
+    const uint8_t*    numDevices()                const   {return _numDevices;}
+    const uint8_t*    numServices()               const   {return _numServices;}
+    const SSDPSpan*   column(SSDPColumn c)        const   {return (((c >= 0) && (c < SSDP_COLUMNS))?(_columns[c]):(NULL));}
+
+    size_t            copy(const SSDPDatagram& d, int row, SSDPColumn c, char buffer[], size_t size) const;  // Copy a field of row, parsed from d
+
+  private:
+    friend class SSDPBulkParser;
+
+    int               _capacity = 0;
+    int               _size     = 0;
+    uint8_t*          _block    = NULL;
+    uint8_t*          _flags    = NULL;
+    uint8_t*          _kinds    = NULL;
+    uint8_t*          _numDevices  = NULL;
+    uint8_t*          _numServices = NULL;
+    SSDPSpan*         _columns[SSDP_COLUMNS];
+
+    SSDPParseTable(const SSDPParseTable&)            = delete;
+    SSDPParseTable& operator=(const SSDPParseTable&) = delete;
+};
+
+/**
+ *  Parse captured search responses in bulk, for offline analysis of recorded traffic. Each datagram is read once, line
+ *  by line, and its headers are recorded as spans rather than copied, so nothing is allocated per datagram. Rows are
+ *  appended to table; datagrams beyond its capacity are not parsed.
+ *  On ESP32 the batch is split into workers contiguous ranges (at most one per core), each parsed by its own task into
+ *  its own rows of the table. On ESP8266 the batch is parsed by the caller.
+ */
+class SSDPBulkParser {
+  public:
+    static int        parse(const SSDPDatagram batch[], int count, SSDPParseTable& table, int workers = 1);  // Returns rows added
+    static uint8_t    parse(const SSDPDatagram& d, SSDPParseTable& table, int row);                          // Parse d into row, returns its flags
+
+  private:
+    static void       parse(const SSDPDatagram batch[], SSDPParseTable& table, int row, int count);  // Parse count datagrams into rows from row
+    static void       parseDesc(const char* base, const char* value, const char* end, SSDPParseTable& table, int row);
+#if defined(ESP32)
+    static void       task(void* arg);
+#endif
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPBurst.h"
+
+namespace lsc {
+
+#if SSDP_RESPONDER
+
+SSDPBurstTable::SSDPBurstTable() {
+  for( int i=0; i<SSDP_BURST_HOLD; i++ ) _bursts[i].id = 0;
+#ifdef ESP32
+  _nextId = esp_random();
+#elif defined(ESP8266)
+  _nextId = RANDOM_REG32;
+#else
+  _nextId = 1;
+#endif
+}
+
+SSDPBurst* SSDPBurstTable::start(IPAddress remoteAddr, const char* st, const char* uuid, const SSDPFilter& filter) {
+  SSDPBurst* result = &_bursts[0];
+  unsigned long now = millis();
+  for( int i=0; i<SSDP_BURST_HOLD; i++ ) {
+    SSDPBurst* b = &_bursts[i];
+    if( (b->id == 0) || (now - b->sent >= BURST_HOLD_TIME) ) {result = b; break;}
+    if( now - b->sent > now - result->sent ) result = b;
+  }
+  renew(result);
+  result->remoteAddr = remoteAddr;
+  result->filter     = filter;
+  result->total      = 0;
+  result->hash       = 0;
+  strncpy(result->st,st,ST_HEADER_SIZE-1);
+  result->st[ST_HEADER_SIZE-1] = '\0';
+  strncpy(result->uuid,uuid,SSDP_UUID_SIZE-1);
+  result->uuid[SSDP_UUID_SIZE-1] = '\0';
+  return result;
+}
+
+void SSDPBurstTable::renew(SSDPBurst* burst) {
+  if( ++_nextId == 0 ) _nextId = 1;
+  burst->id   = _nextId;
+  burst->sent = millis();
+}
+
+SSDPBurst* SSDPBurstTable::find(uint32_t id, IPAddress remoteAddr) {
+  unsigned long now = millis();
+  for( int i=0; i<SSDP_BURST_HOLD; i++ ) {
+    SSDPBurst* b = &_bursts[i];
+    if( (id != 0) && (b->id == id) && (b->remoteAddr == remoteAddr) && (now - b->sent < BURST_HOLD_TIME) ) return b;
+  }
+  return NULL;
+}
+
+boolean SSDPBurstTable::parse(const char* value, uint32_t& id, const char** missing) {
+  const char* i = strstr_P(value,BURST_ID);
+  const char* m = strstr_P(value,BURST_MISSING);
+  if( (i == NULL) || (m == NULL) ) return false;
+  id       = strtoul(i+strlen_P(BURST_ID),NULL,10);
+  *missing = m + strlen_P(BURST_MISSING);
+  return true;
+}
+
+/**
+ *  The list is indices and ranges separated by ',' and ended by ':' or the end of the string
+ */
+boolean SSDPBurstTable::listed(const char* missing, int index) {
+  const char* p = missing;
+  while( isdigit(*p) ) {
+    char* end;
+    long first = strtol(p,&end,10);
+    long last  = first;
+    if( *end == '-' ) last = strtol(end+1,&end,10);
+    if( (index >= first) && (index <= last) ) return true;
+    if( *end != ',' ) break;
+    p = end + 1;
+  }
+  return false;
+}
+
+#endif
+
+#if SSDP_CLIENT
+
+const char BURST_USN_HEADER[] PROGMEM = "USN";
+
+SSDPBurstTracker::SSDPBurstTracker() {
+  _keys = (uint32_t*)malloc(SSDP_BURST_TRACKS*SSDP_BURST_RECORDS*sizeof(uint32_t));
+  clear();
+}
+
+SSDPBurstTracker::~SSDPBurstTracker() {
+  if( _keys != NULL ) free(_keys);
+}
+
+void SSDPBurstTracker::clear() {_count = 0;}
+
+/**
+ *  Responses without a BURST header, and bursts that can not be tracked, are always new. A new burst id from a tracked
+ *  responder retires its old burst; late records of the retired burst are delivered only if their key is new.
+ */
+boolean SSDPBurstTracker::add(UPnPBuffer* b, IPAddress remoteAddr) {
+  uint32_t id;
+  int      index, total;
+  if( !b->burst(id,index,total) || (total <= 0) || (total > SSDP_BURST_RECORDS) || (index < 0) || (index >= total) ) return true;
+  Track* t = NULL;
+  for( int i=0; (i<_count) && (t == NULL); i++ ) {
+    if( _tracks[i].remoteAddr == remoteAddr ) t = &_tracks[i];
+  }
+  if( t == NULL ) {
+    if( _count == SSDP_BURST_TRACKS ) return true;
+    t = &_tracks[_count++];
+    t->remoteAddr = remoteAddr;
+    t->id         = id;
+    t->retired    = 0;
+    t->total      = total;
+    t->delivered  = 0;
+    memset(t->seen,0,sizeof(t->seen));
+  }
+  else if( (id != t->id) && (id == t->retired) ) return deliver(*t,b);
+  else if( id != t->id ) {
+    t->retired = t->id;
+    t->id      = id;
+    t->total   = total;
+    memset(t->seen,0,sizeof(t->seen));
+  }
+  if( isSeen(*t,index) ) return false;
+  t->seen[index/8] |= (1 << (index%8));
+  return deliver(*t,b);
+}
+
+/**
+ *  Keys are an FNV-1a hash of the uuid and type of the USN. A record without a USN, or past the key space, is delivered.
+ */
+boolean SSDPBurstTracker::deliver(Track& t, UPnPBuffer* b) {
+  char usn[SSDP_HEADER_BUFFER_SIZE];
+  const char* uuid;
+  const char* type;
+  size_t      uuidLen, typeLen;
+  if( (_keys == NULL) || !b->headerValue_P(BURST_USN_HEADER,usn,SSDP_HEADER_BUFFER_SIZE) || 
+      !UPnPBuffer::splitUSN(usn,strlen(usn),&uuid,&uuidLen,&type,&typeLen) ) return true;
+  uint32_t key = 2166136261UL;
+  for( size_t i=0; i<uuidLen; i++ ) {key ^= (uint8_t)uuid[i]; key *= 16777619UL;}
+  key ^= ':'; key *= 16777619UL;
+  for( size_t i=0; i<typeLen; i++ ) {key ^= (uint8_t)type[i]; key *= 16777619UL;}
+  uint32_t* keys = _keys + (&t - _tracks)*SSDP_BURST_RECORDS;
+  for( int i=0; i<t.delivered; i++ ) if( keys[i] == key ) return false;
+  if( t.delivered < SSDP_BURST_RECORDS ) keys[t.delivered++] = key;
+  return true;
+}
+
+/**
+ *  Render the missing indices of each incomplete burst as ranges. A list too long for a request header is cut short,
+ *  and the rest is left for the next re-request.
+ */
+int SSDPBurstTracker::incomplete(std::function<void(IPAddress,uint32_t,const char*)> handler) {
+  int result = 0;
+  for( int i=0; i<_count; i++ ) {
+    const Track& t = _tracks[i];
+    char list[BURST_LIST_SIZE];
+    size_t len = 0;
+    list[0] = '\0';
+    for( int j=0; j<t.total; j++ ) {
+      if( isSeen(t,j) ) continue;
+      int last = j;
+      while( (last+1 < t.total) && !isSeen(t,last+1) ) last++;
+      char range[16];
+      int n = ((last > j)?(snprintf(range,sizeof(range),"%s%d-%d",((len>0)?(","):("")),j,last)):
+                          (snprintf(range,sizeof(range),"%s%d",((len>0)?(","):("")),j)));
+      if( len + n >= sizeof(list) ) break;
+      memcpy(list+len,range,n+1);
+      len += n;
+      j = last;
+    }
+    if( len > 0 ) {
+      handler(t.remoteAddr,t.id,list);
+      result++;
+    }
+  }
+  return result;
+}
+
+int SSDPBurstTracker::missing() const {
+  int result = 0;
+  for( int i=0; i<_count; i++ ) {
+    for( int j=0; j<_tracks[i].total; j++ ) if( !isSeen(_tracks[i],j) ) result++;
+  }
+  return result;
+}
+
+#endif
+
+} // End of namespace lsc
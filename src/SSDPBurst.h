@@ -0,0 +1,114 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPBURST_H
+#define SSDPBURST_H
+
+#include <Arduino.h>
+#include "SSDPConfig.h"
+#include "SSDPHeaders.h"
+#include "SSDPFilter.h"
+#include "UPnPBuffer.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define BURST_HOLD_TIME      10000         // Milliseconds a responder holds a burst for re-requests
+#define BURST_RETRY_TIMEOUT  500           // Milliseconds a client waits for re-requested records
+
+/**
+ *  The responses to one ssdp:all request form a burst. Each response carries a BURST.LEELANAUSOFTWARE.COM header of
+ *  :id:burst-id:index:i:total:n:, so a client can tell which records were lost, and re-request them from the responder
+ *  with a unicast request carrying :id:burst-id:missing:list: where list is indices and ranges, for example 3,7,9-12.
+ *  A responder does not copy the records of a burst. It holds how the burst was produced (search target, filter and
+ *  requester) with a hash of the records in order, and walks the same nodes again to answer a re-request. If the 
+ *  nodes changed in the meantime, the whole burst is sent again under a new id.
+ */
+typedef struct SSDPBurst {
+  uint32_t        id;                                // 0 if the slot is free
+  unsigned long   sent;                              // millis() when the burst was sent
+  IPAddress       remoteAddr;                        // Requester
+  int             total;
+  uint32_t        hash;                              // Hash of the burst's records in order
+  SSDPFilter      filter;                            // Filter of the original request
+  char            st[ST_HEADER_SIZE];
+  char            uuid[SSDP_UUID_SIZE];              // Device of a uuid: burst, empty for upnp:rootdevice
+} SSDPBurst;
+
+/**
+ *  Bursts held by a responder. A new burst takes a free or expired slot, or the oldest one.
+ */
+class SSDPBurstTable {
+  public:
+    SSDPBurstTable();
+
+    SSDPBurst*      start(IPAddress remoteAddr, const char* st, const char* uuid, const SSDPFilter& filter);  // Hold a new burst
+    SSDPBurst*      find(uint32_t id, IPAddress remoteAddr);   // Held burst, NULL if unknown or expired
+    void            renew(SSDPBurst* burst);                   // Give a held burst a new id
+
+    static boolean  parse(const char* value, uint32_t& id, const char** missing);  // Parse a re-request header value
+    static boolean  listed(const char* missing, int index);    // Return true if index is in a list of indices and ranges
+
+  private:
+    SSDPBurst       _bursts[SSDP_BURST_HOLD];
+    uint32_t        _nextId;
+};
+
+/**
+ *  Client side record of the bursts received during a search, one per responder, so lost records can be re-requested.
+ *  Bursts larger than SSDP_BURST_RECORDS are not tracked. If a responder's records change, it answers a re-request 
+ *  with the whole burst under a new id (see SSDPBurst); the new burst then replaces the responder's track, and records
+ *  already delivered under the old id, keyed by the uuid and type of their USN, are not delivered again.
+ */
+class SSDPBurstTracker {
+  public:
+    SSDPBurstTracker();
+    ~SSDPBurstTracker();
+
+    void            clear();
+    boolean         add(UPnPBuffer* b, IPAddress remoteAddr);  // Record b, returns false if it was already received
+    int             incomplete(std::function<void(IPAddress,uint32_t,const char*)> handler);  // Call handler with the missing list of each incomplete burst
+    int             missing() const;                           // Records not yet received, over all tracked bursts
+
+  private:
+    typedef struct {
+      IPAddress     remoteAddr;
+      uint32_t      id;
+      uint32_t      retired;                                   // Id the responder replaced by id, 0 if none
+      int           total;
+      int           delivered;                                 // Keys of the records delivered from this responder
+      uint8_t       seen[SSDP_BURST_RECORDS/8];
+    } Track;
+
+    Track           _tracks[SSDP_BURST_TRACKS];
+    int             _count;
+    uint32_t*       _keys;                                     // SSDP_BURST_RECORDS keys per track, NULL if not allocated
+
+    boolean         deliver(Track& t, UPnPBuffer* b);          // Return false if a record with the uuid and type of b was delivered
+    static boolean  isSeen(const Track& t, int i)      {return (t.seen[i/8] & (1 << (i%8))) != 0;}
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,298 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPChangeLog.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+/**
+ *  Snapshot nodes are packed back to back: kind (1 byte), state hash (4 bytes), then root uuid, uuid and type, each
+ *  null terminated.
+ */
+typedef struct {
+  SSDPRecordKind  kind;
+  uint32_t        state;
+  const char*     root;
+  const char*     uuid;
+  const char*     type;
+} PackedNode;
+
+static const char* str(const char* s) {return ((s != NULL)?(s):(""));}
+
+static uint32_t hash(uint32_t h, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  for( size_t i=0; i<len; i++ ) {h ^= p[i]; h *= 16777619UL;}
+  return h;
+}
+
+/**
+ *  Hash of the fields that can change without changing the node's identity
+ */
+static uint32_t state(const SSDPNode& node) {
+  uint32_t h = 2166136261UL;
+  h = hash(h,str(node.name),strlen(str(node.name))+1);
+  h = hash(h,str(node.puuid),strlen(str(node.puuid))+1);
+  h = hash(h,&node.numDevices,sizeof(node.numDevices));
+  h = hash(h,&node.numServices,sizeof(node.numServices));
+  return h;
+}
+
+static size_t pack(uint8_t* p, const SSDPNode& node, const char* root) {
+  size_t r = strlen(root) + 1;
+  size_t u = strlen(str(node.uuid)) + 1;
+  size_t t = strlen(str(node.type)) + 1;
+  if( p != NULL ) {
+    uint32_t s = state(node);
+    p[0] = (uint8_t)node.kind;
+    memcpy(p+1,&s,4);
+    memcpy(p+5,root,r);
+    memcpy(p+5+r,str(node.uuid),u);
+    memcpy(p+5+r+u,str(node.type),t);
+  }
+  return 5 + r + u + t;
+}
+
+static const uint8_t* unpack(const uint8_t* p, PackedNode& n) {
+  n.kind = (SSDPRecordKind)p[0];
+  memcpy(&n.state,p+1,4);
+  n.root = (const char*)(p+5);
+  n.uuid = n.root + strlen(n.root) + 1;
+  n.type = n.uuid + strlen(n.uuid) + 1;
+  return (const uint8_t*)(n.type + strlen(n.type) + 1);
+}
+
+/**
+ *  Snapshot order: kind, then uuid, then type
+ */
+static int compare(const PackedNode& a, const PackedNode& b) {
+  if( a.kind != b.kind ) return ((a.kind < b.kind)?(-1):(1));
+  int c = strcmp(a.uuid,b.uuid);
+  return ((c != 0)?(c):(strcmp(a.type,b.type)));
+}
+
+static int compareNodes(const void* a, const void* b) {
+  PackedNode x, y;
+  unpack(*(const uint8_t* const*)a,x);
+  unpack(*(const uint8_t* const*)b,y);
+  return compare(x,y);
+}
+
+/**
+ *  Return a copy of the used bytes of packed with its nodes in snapshot order, or NULL if out of memory. packed is 
+ *  released either way.
+ */
+static uint8_t* sortSnapshot(uint8_t* packed, size_t used) {
+  if( used == 0 ) return packed;
+  size_t count = 0;
+  PackedNode n;
+  for( const uint8_t* p = packed; p < packed + used; count++ ) p = unpack(p,n);
+  const uint8_t** nodes  = new(std::nothrow) const uint8_t*[count];
+  uint8_t*        result = new(std::nothrow) uint8_t[used];
+  if( (nodes != NULL) && (result != NULL) ) {
+    const uint8_t* p = packed;
+    for( size_t i=0; i<count; i++ ) {
+      nodes[i] = p;
+      p = unpack(p,n);
+    }
+    qsort(nodes,count,sizeof(const uint8_t*),compareNodes);
+    uint8_t* out = result;
+    for( size_t i=0; i<count; i++ ) {
+      size_t len = unpack(nodes[i],n) - nodes[i];
+      memcpy(out,nodes[i],len);
+      out += len;
+    }
+  }
+  else if( result != NULL ) {
+    delete[] result;
+    result = NULL;
+  }
+  if( nodes != NULL ) delete[] nodes;
+  delete[] packed;
+  return result;
+}
+
+/**
+ *  First generation, random so generations do not repeat across restarts. Leaves room to count up without wrapping.
+ */
+static uint32_t seed() {
+#ifdef ESP32
+  return (esp_random() & 0x3FFFFFFF) + 1;
+#elif defined(ESP8266)
+  return (RANDOM_REG32 & 0x3FFFFFFF) + 1;
+#else
+  return 1;
+#endif
+}
+
+boolean SSDPChangeLog::begin(int capacity) {
+  end();
+  if( capacity > 0 ) _log = new(std::nothrow) SSDPChange[capacity];
+  if( _log != NULL ) {
+    _capacity   = capacity;
+    _generation = seed();
+    _base       = _generation;
+  }
+  return (_log != NULL);
+}
+
+void SSDPChangeLog::end() {
+  if( _log != NULL ) delete[] _log;
+  if( _snapshot != NULL ) delete[] _snapshot;
+  _log      = NULL;
+  _snapshot = NULL;
+  _snapSize = 0;
+  _capacity = 0;
+  _count    = 0;
+  _head     = 0;
+  _synced   = false;
+}
+
+/**
+ *  Call handler on every node of provider with the uuid of its RootDevice
+ */
+void SSDPChangeLog::walk(SSDPNodeProvider* provider, std::function<void(const SSDPNode&,const char*)> handler) {
+  std::function<void(const SSDPNode&,const char*)> visit;
+  visit = [provider,&handler,&visit](const SSDPNode& node, const char* root) {
+    handler(node,root);
+    provider->children(node,[&visit,root](const SSDPNode& child) {visit(child,root);});
+  };
+  provider->roots([&visit](const SSDPNode& root) {
+    char uuid[SSDP_UUID_SIZE];
+    strncpy(uuid,str(root.uuid),SSDP_UUID_SIZE-1);
+    uuid[SSDP_UUID_SIZE-1] = '\0';
+    visit(root,uuid);
+  });
+}
+
+/**
+ *  Snapshot the provider and compare it with the previous snapshot. The first sync only takes the snapshot. If the
+ *  snapshot can not be allocated, the log is cleared (see resync).
+ */
+int SSDPChangeLog::sync(SSDPNodeProvider* provider) {
+  if( !isEnabled() || (provider == NULL) ) return 0;
+  size_t size = 0;
+  walk(provider,[&size](const SSDPNode& node, const char* root) {size += pack(NULL,node,root);});
+  uint8_t* snapshot = ((size > 0)?(new(std::nothrow) uint8_t[size]):(NULL));
+  if( (size > 0) && (snapshot == NULL) ) return resync();
+  size_t used = 0;
+  walk(provider,[snapshot,size,&used](const SSDPNode& node, const char* root) {
+    if( used + pack(NULL,node,root) <= size ) used += pack(snapshot+used,node,root);
+  });
+  snapshot = sortSnapshot(snapshot,used);
+  if( (used > 0) && (snapshot == NULL) ) return resync();
+
+/**
+ *  Both snapshots are in snapshot order, so one merge pass finds nodes added, removed and changed
+ */
+  int result = 0;
+  if( _synced ) {
+    uint32_t next = _generation + 1;
+    PackedNode n, o;
+    const uint8_t* p = snapshot;
+    const uint8_t* q = _snapshot;
+    const uint8_t* pEnd = snapshot + used;
+    const uint8_t* qEnd = _snapshot + _snapSize;
+    while( (p < pEnd) || (q < qEnd) ) {
+      if( p < pEnd ) unpack(p,n);
+      if( q < qEnd ) unpack(q,o);
+      int c = ((p >= pEnd)?(1):((q >= qEnd)?(-1):(compare(n,o))));
+      if( c < 0 ) {record(next,SSDP_NODE_ADDED,n.kind,n.root,n.uuid,n.type); result++;}
+      else if( c > 0 ) {record(next,SSDP_NODE_REMOVED,o.kind,o.root,o.uuid,o.type); result++;}
+      else if( o.state != n.state ) {record(next,SSDP_NODE_CHANGED,n.kind,n.root,n.uuid,n.type); result++;}
+      if( c <= 0 ) p = unpack(p,n);
+      if( c >= 0 ) q = unpack(q,o);
+    }
+    if( result > 0 ) _generation = next;
+  }
+  else _base = _generation;
+  if( _snapshot != NULL ) delete[] _snapshot;
+  _snapshot = snapshot;
+  _snapSize = used;
+  _synced   = true;
+  return result;
+}
+
+/**
+ *  Drop the snapshot and the log when a snapshot can not be allocated. The generation is advanced, so every client 
+ *  is sent a full tree, and the next sync takes a new snapshot.
+ */
+int SSDPChangeLog::resync() {
+  if( _snapshot != NULL ) delete[] _snapshot;
+  _snapshot = NULL;
+  _snapSize = 0;
+  _synced   = false;
+  _count    = 0;
+  _head     = 0;
+  _base     = ++_generation;
+  return 0;
+}
+
+/**
+ *  Append a change, dropping the oldest change if the log is full. Generations up to the dropped change's generation 
+ *  may have missed it, so the log can only answer from that generation on.
+ */
+void SSDPChangeLog::record(uint32_t generation, SSDPChangeKind change, SSDPRecordKind kind, const char* root, const char* uuid, 
+                           const char* type) {
+  if( _count == _capacity ) {
+    _base = _log[_head].generation;
+    _head = (_head + 1) % _capacity;
+    _count--;
+  }
+  SSDPChange& c = _log[(_head + _count) % _capacity];
+  c.generation = generation;
+  c.change     = change;
+  c.kind       = kind;
+  strncpy(c.root,root,SSDP_UUID_SIZE-1);
+  c.root[SSDP_UUID_SIZE-1] = '\0';
+  strncpy(c.uuid,uuid,SSDP_UUID_SIZE-1);
+  c.uuid[SSDP_UUID_SIZE-1] = '\0';
+  strncpy(c.type,type,SSDP_TYPE_SIZE-1);
+  c.type[SSDP_TYPE_SIZE-1] = '\0';
+  _count++;
+}
+
+/**
+ *  Walk the log newest first, reporting a node only for its latest change
+ */
+int SSDPChangeLog::changes(const char* root, uint32_t since, SSDPChangeHandler handler) const {
+  int result = 0;
+  for( int i=_count-1; (i>=0) && (at(i).generation > since); i-- ) {
+    const SSDPChange& c = at(i);
+    if( strcmp(c.root,root) != 0 ) continue;
+    boolean newer = false;
+    for( int j=i+1; (j<_count) && !newer; j++ ) {
+      const SSDPChange& d = at(j);
+      newer = (d.kind == c.kind) && (strcmp(d.uuid,c.uuid) == 0) && (strcmp(d.type,c.type) == 0);
+    }
+    if( !newer ) {
+      handler(c);
+      result++;
+    }
+  }
+  return result;
+}
+
+} // End of namespace lsc
+
+#endif
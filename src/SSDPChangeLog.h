@@ -0,0 +1,106 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPCHANGELOG_H
+#define SSDPCHANGELOG_H
+
+#include <Arduino.h>
+#include <new>
+#include "SSDPConfig.h"
+#include "SSDPNodeProvider.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+typedef enum {
+  SSDP_NODE_ADDED   = 0,
+  SSDP_NODE_REMOVED = 1,
+  SSDP_NODE_CHANGED = 2                          // Name, parent or device/service counts changed
+} SSDPChangeKind;
+
+/**
+ *  A change to a node, identified as in its USN by kind, uuid and type. For a service, uuid is the uuid of its device.
+ */
+typedef struct SSDPChange {
+  uint32_t        generation;                    // Generation the change was made in
+  SSDPChangeKind  change;
+  SSDPRecordKind  kind;
+  char            root[SSDP_UUID_SIZE];          // uuid of the RootDevice the node belongs to
+  char            uuid[SSDP_UUID_SIZE];
+  char            type[SSDP_TYPE_SIZE];
+} SSDPChange;
+
+typedef std::function<void(const SSDPChange&)> SSDPChangeHandler;
+
+/**
+ *  Generation number and bounded log of topology changes for the nodes of a provider, so a client that mirrors a 
+ *  RootDevice can ask for what changed since the generation it holds instead of repeating ssdp:all. 
+ *  sync() compares the provider with a snapshot taken by the previous sync() and logs each node added, removed or 
+ *  changed, all under one new generation. Snapshots are sorted by kind, uuid and type, so the comparison is a single
+ *  merge pass and sync() takes O(N log N) for N nodes. The log holds capacity changes; when it is full the oldest change is 
+ *  dropped and generations before it can no longer be answered from the log (see covers).
+ *  The first generation is random, so a generation held from before a restart is not mistaken for a current one.
+ */
+class SSDPChangeLog {
+  public:
+    SSDPChangeLog() {}
+    ~SSDPChangeLog()                                       {end();}
+
+    boolean     begin(int capacity);                       // Allocate capacity changes, returns false if out of memory
+    void        end();                                     // Release the log and snapshot
+    boolean     isEnabled()                    const       {return _log != NULL;}
+    int         capacity()                     const       {return _capacity;}
+    int         size()                         const       {return _count;}
+    uint32_t    generation()                   const       {return _generation;}
+    size_t      memoryUsed()                   const       {return _capacity*sizeof(SSDPChange) + _snapSize;}
+
+    int         sync(SSDPNodeProvider* provider);          // Log changes since the last sync, returns the number of changes
+    boolean     covers(uint32_t since)         const       {return isEnabled() && (since >= _base) && (since <= _generation);}
+    int         changes(const char* root, uint32_t since, SSDPChangeHandler handler) const; // Latest change per node of root after since
+
+  private:
+    SSDPChange* _log        = NULL;
+    int         _capacity   = 0;
+    int         _count      = 0;
+    int         _head       = 0;                           // Index of the oldest change
+    uint32_t    _generation = 0;
+    uint32_t    _base       = 0;                           // Oldest generation the log can answer from
+    uint8_t*    _snapshot   = NULL;                        // Packed nodes of the last sync: kind, state, root, uuid, type, sorted
+    size_t      _snapSize   = 0;
+
+    boolean     _synced     = false;                       // A snapshot has been taken
+
+    void        record(uint32_t generation, SSDPChangeKind change, SSDPRecordKind kind, const char* root, const char* uuid, 
+                       const char* type);
+    const SSDPChange& at(int i)                const       {return _log[(_head + i) % _capacity];}
+    static void walk(SSDPNodeProvider* provider, std::function<void(const SSDPNode&,const char*)> handler);
+    int         resync();                                  // Drop the snapshot and log, returns 0
+
+    SSDPChangeLog(const SSDPChangeLog&)            = delete;
+    SSDPChangeLog& operator=(const SSDPChangeLog&) = delete;
+};
+
+} // End of namespace lsc
+
+#endif
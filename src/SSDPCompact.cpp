@@ -0,0 +1,287 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPCompact.h"
+#include "SSDPConfig.h"
+
+namespace lsc {
+
+#define COMPACT_TYPE_SIZE  SSDP_TYPE_SIZE
+#define COMPACT_UUID_SIZE  SSDP_UUID_SIZE
+#define COMPACT_NAME_SIZE  SSDP_NAME_SIZE
+#define COMPACT_LOC_SIZE   SSDP_HEADER_BUFFER_SIZE
+
+/**
+ *  Well known type prefixes, dictionary code is index+1 and 0 means no prefix
+ */
+const char COMPACT_PREFIX_0[] PROGMEM = "urn:LEELANAUSOFTWARE-com:device:";
+const char COMPACT_PREFIX_1[] PROGMEM = "urn:LEELANAUSOFTWARE-com:service:";
+const char COMPACT_PREFIX_2[] PROGMEM = "urn:LeelanauSoftwareCo-com:device:";
+const char COMPACT_PREFIX_3[] PROGMEM = "urn:LeelanauSoftwareCo-com:service:";
+const char COMPACT_PREFIX_4[] PROGMEM = "urn:schemas-upnp-org:device:";
+const char COMPACT_PREFIX_5[] PROGMEM = "urn:schemas-upnp-org:service:";
+PGM_P const COMPACT_PREFIXES[] = {COMPACT_PREFIX_0,COMPACT_PREFIX_1,COMPACT_PREFIX_2,COMPACT_PREFIX_3,COMPACT_PREFIX_4,COMPACT_PREFIX_5};
+const int COMPACT_PREFIX_COUNT = sizeof(COMPACT_PREFIXES)/sizeof(PGM_P);
+
+const char COMPACT_ROOTDEVICE[] PROGMEM = "upnp:rootdevice";
+const char COMPACT_UUID[]       PROGMEM = "uuid:";
+const char COMPACT_HTTP[]       PROGMEM = "http://";
+
+/**
+ *  Bounded writer and reader over a byte buffer. Once a write or read runs past the end, the stream is marked bad and
+ *  ignores further operations.
+ */
+class CompactWriter {
+  public:
+    CompactWriter(uint8_t* buffer, size_t size) : _buffer(buffer), _size(size) {}
+    void      byte(uint8_t b)                      {if( _len < _size ) _buffer[_len++] = b; else _ok = false;}
+    void      varint(uint32_t v)                   {while( v >= 0x80 ) {byte((v & 0x7F) | 0x80); v >>= 7;} byte(v);}
+    void      bytes(const uint8_t* b, size_t n)    {for( size_t i=0; i<n; i++ ) byte(b[i]);}
+    void      string(const char* s, size_t n)      {varint(n); bytes((const uint8_t*)s,n);}
+    void      string(const char* s)                {string(s,strlen(s));}
+    size_t    length()                  const      {return ((_ok)?(_len):(0));}
+  private:
+    uint8_t*  _buffer;
+    size_t    _size;
+    size_t    _len = 0;
+    boolean   _ok  = true;
+};
+
+class CompactReader {
+  public:
+    CompactReader(const uint8_t* buffer, size_t len) : _buffer(buffer), _len(len) {}
+    uint8_t   byte()                               {if( _pos < _len ) return _buffer[_pos++]; _ok = false; return 0;}
+    uint32_t  varint() {
+      uint32_t v = 0;
+      for( int shift=0; (shift<32) && _ok; shift+=7 ) {
+        uint8_t b = byte();
+        v |= ((uint32_t)(b & 0x7F)) << shift;
+        if( (b & 0x80) == 0 ) break;
+      }
+      return v;
+    }
+    const char* string(size_t& n) {
+      n = varint();
+      if( !_ok || (n > _len - _pos) ) {_ok = false; n = 0; return "";}
+      const char* result = (const char*)(_buffer + _pos);
+      _pos += n;
+      return result;
+    }
+    const uint8_t* bytes(size_t n) {
+      if( n > _len - _pos ) {_ok = false; return NULL;}
+      const uint8_t* result = _buffer + _pos;
+      _pos += n;
+      return result;
+    }
+    boolean   ok()                      const      {return _ok;}
+  private:
+    const uint8_t* _buffer;
+    size_t    _len;
+    size_t    _pos = 0;
+    boolean   _ok  = true;
+};
+
+int hexValue(char c) {
+  if( (c >= '0') && (c <= '9') ) return c - '0';
+  if( (c >= 'a') && (c <= 'f') ) return c - 'a' + 10;
+  return -1;
+}
+
+/**
+ *  Parse a canonical xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx uuid into 16 bytes, returns false if uuid is not canonical.
+ *  Hex digits must be lowercase, as unpackUUID writes them, so a uuid with uppercase digits is sent as text and keeps
+ *  its case.
+ */
+boolean packUUID(const char* uuid, uint8_t out[16]) {
+  if( strlen(uuid) != 36 ) return false;
+  int n = 0;
+  for( int i=0; i<36; i++ ) {
+    if( (i==8) || (i==13) || (i==18) || (i==23) ) {
+      if( uuid[i] != '-' ) return false;
+      continue;
+    }
+    int hi = hexValue(uuid[i]);
+    int lo = hexValue(uuid[++i]);
+    if( (hi < 0) || (lo < 0) ) return false;
+    out[n++] = (hi << 4) | lo;
+  }
+  return true;
+}
+
+void unpackUUID(const uint8_t in[16], char out[]) {
+  const char* hex = "0123456789abcdef";
+  int n = 0;
+  for( int i=0; i<16; i++ ) {
+    if( (i==4) || (i==6) || (i==8) || (i==10) ) out[n++] = '-';
+    out[n++] = hex[in[i] >> 4];
+    out[n++] = hex[in[i] & 0x0F];
+  }
+  out[n] = '\0';
+}
+
+void writeUUID(CompactWriter& w, const char* uuid, boolean literal) {
+  uint8_t packed[16];
+  if( !literal && packUUID(uuid,packed) ) w.bytes(packed,16);
+  else w.string(uuid);
+}
+
+void readUUID(CompactReader& r, boolean literal, char out[COMPACT_UUID_SIZE]) {
+  out[0] = '\0';
+  if( literal ) {
+    size_t n;
+    const char* s = r.string(n);
+    if( n >= COMPACT_UUID_SIZE ) n = COMPACT_UUID_SIZE - 1;
+    memcpy(out,s,n);
+    out[n] = '\0';
+  }
+  else {
+    const uint8_t* packed = r.bytes(16);
+    if( packed != NULL ) unpackUUID(packed,out);
+  }
+}
+
+#if SSDP_RESPONDER
+size_t SSDPCompact::encode(uint8_t buffer[], size_t size, const SSDPCompactFields& f, IPAddress ifc) {
+  CompactWriter w(buffer,size);
+  uint8_t packed[16];
+  boolean literal = !packUUID(f.uuid,packed) || ((f.kind != SSDP_ROOT_RECORD) && !packUUID(f.puuid,packed));
+  w.byte(COMPACT_MAGIC);
+  w.byte((COMPACT_VERSION << 4) | ((f.kind & 0x03) << 2) | ((literal)?(COMPACT_LITERAL_UUID):(0)));
+  writeUUID(w,f.uuid,literal);
+  if( f.kind != SSDP_ROOT_RECORD ) writeUUID(w,f.puuid,literal);
+  if( f.kind == SSDP_ROOT_RECORD ) w.varint(f.numDevices);
+  if( f.kind != SSDP_SERVICE_RECORD ) w.varint(f.numServices);
+
+  const char* type = f.type;
+  uint8_t code = 0;
+  for( int i=0; (i<COMPACT_PREFIX_COUNT) && (code == 0); i++ ) {
+    size_t n = strlen_P(COMPACT_PREFIXES[i]);
+    if( strncmp_P(type,COMPACT_PREFIXES[i],n) == 0 ) {code = i+1; type += n;}
+  }
+  w.byte(code);
+  w.string(type);
+
+  if( strcmp_P(f.st,COMPACT_ROOTDEVICE) == 0 ) w.byte(COMPACT_ST_ROOTDEVICE);
+  else if( (strncmp_P(f.st,COMPACT_UUID,5) == 0) && (strcmp(f.st+5,f.uuid) == 0) ) w.byte(COMPACT_ST_UUID);
+  else if( strcmp(f.st,f.type) == 0 ) w.byte(COMPACT_ST_TYPE);
+  else {w.byte(COMPACT_ST_LITERAL); w.string(f.st);}
+
+  w.string(f.name);
+
+/**
+ *  Location is normally http://ifc:port/path, where ifc is the source address of the response
+ */
+  char host[24];
+  snprintf_P(host,sizeof(host),PSTR("http://%d.%d.%d.%d:"),ifc[0],ifc[1],ifc[2],ifc[3]);
+  size_t hostLen = strlen(host);
+  const char* loc = f.location;
+  if( (strncmp(loc,host,hostLen) == 0) && isdigit(loc[hostLen]) ) {
+    char* path = NULL;
+    unsigned long port = strtoul(loc+hostLen,&path,10);
+    w.byte(COMPACT_LOC_SOURCE);
+    w.varint(port);
+    w.string(path);
+  }
+  else {w.byte(COMPACT_LOC_LITERAL); w.string(loc);}
+  return w.length();
+}
+
+#endif
+
+#if SSDP_CLIENT
+SSDPRecord* SSDPCompact::decode(const uint8_t packet[], size_t len, IPAddress remote, const char* ST, SSDPResponseSet& results) {
+  CompactReader r(packet,len);
+  if( r.byte() != COMPACT_MAGIC ) return NULL;
+  uint8_t header = r.byte();
+  if( (header >> 4) != COMPACT_VERSION ) return NULL;
+  SSDPRecordKind kind = (SSDPRecordKind)((header >> 2) & 0x03);
+  if( kind > SSDP_SERVICE_RECORD ) return NULL;
+  boolean literal = ((header & COMPACT_LITERAL_UUID) != 0);
+
+  char uuid[COMPACT_UUID_SIZE];
+  char puuid[COMPACT_UUID_SIZE];
+  puuid[0] = '\0';
+  readUUID(r,literal,uuid);
+  if( kind != SSDP_ROOT_RECORD ) readUUID(r,literal,puuid);
+  int numDevices  = ((kind == SSDP_ROOT_RECORD)?(r.varint()):(0));
+  int numServices = ((kind != SSDP_SERVICE_RECORD)?(r.varint()):(0));
+
+  char type[COMPACT_TYPE_SIZE];
+  type[0] = '\0';
+  uint8_t code = r.byte();
+  if( (code > 0) && (code <= COMPACT_PREFIX_COUNT) ) strncpy_P(type,COMPACT_PREFIXES[code-1],COMPACT_TYPE_SIZE-1);
+  else if( code != 0 ) return NULL;
+  type[COMPACT_TYPE_SIZE-1] = '\0';
+  size_t n;
+  const char* rest = r.string(n);
+  size_t prefixLen = strlen(type);
+  if( prefixLen + n >= COMPACT_TYPE_SIZE ) return NULL;
+  memcpy(type+prefixLen,rest,n);
+  type[prefixLen+n] = '\0';
+
+/**
+ *  Responses must match the ST of the request
+ */
+  uint8_t stCode = r.byte();
+  boolean match = false;
+  if( stCode == COMPACT_ST_ROOTDEVICE )  match = (strcmp_P(ST,COMPACT_ROOTDEVICE) == 0);
+  else if( stCode == COMPACT_ST_UUID )   match = (strncmp_P(ST,COMPACT_UUID,5) == 0) && (strcmp(ST+5,uuid) == 0);
+  else if( stCode == COMPACT_ST_TYPE )   match = (strcmp(ST,type) == 0);
+  else {
+    const char* st = r.string(n);
+    match = (strlen(ST) == n) && (strncmp(ST,st,n) == 0);
+  }
+  if( !match || !r.ok() ) return NULL;
+
+  char name[COMPACT_NAME_SIZE];
+  size_t nameLen;
+  const char* nameStr = r.string(nameLen);
+  if( nameLen >= COMPACT_NAME_SIZE ) nameLen = COMPACT_NAME_SIZE - 1;
+  memcpy(name,nameStr,nameLen);
+  name[nameLen] = '\0';
+
+  char location[COMPACT_LOC_SIZE];
+  uint8_t locCode = r.byte();
+  if( locCode == COMPACT_LOC_SOURCE ) {
+    uint32_t port = r.varint();
+    size_t pathLen;
+    const char* path = r.string(pathLen);
+    int hostLen = snprintf_P(location,sizeof(location),PSTR("http://%d.%d.%d.%d:%lu"),remote[0],remote[1],remote[2],remote[3],(unsigned long)port);
+    if( hostLen + pathLen >= sizeof(location) ) return NULL;
+    memcpy(location+hostLen,path,pathLen);
+    location[hostLen+pathLen] = '\0';
+  }
+  else if( locCode == COMPACT_LOC_LITERAL ) {
+    size_t locLen;
+    const char* loc = r.string(locLen);
+    if( locLen >= sizeof(location) ) return NULL;
+    memcpy(location,loc,locLen);
+    location[locLen] = '\0';
+  }
+  else return NULL;
+  if( !r.ok() ) return NULL;
+
+  return results.add(kind,uuid,type,((kind == SSDP_ROOT_RECORD)?(NULL):(puuid)),name,location,numDevices,numServices);
+}
+#endif
+
+} // End of namespace lsc
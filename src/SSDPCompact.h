@@ -0,0 +1,100 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPCOMPACT_H
+#define SSDPCOMPACT_H
+
+#include <Arduino.h>
+#include "SSDPResponseSet.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  Compact binary encoding of an LSC search response (lsc-bin/1). A search request opts in with the header
+ *     ENC.LEELANAUSOFTWARE.COM: lsc-bin/1
+ *  and each response is then a single binary record carrying the same information as the text response:
+ *     magic       1 byte    COMPACT_MAGIC, never the first byte of a text response
+ *     header      1 byte    version (high nibble), record kind (bits 2-3), COMPACT_LITERAL_UUID (bit 0)
+ *     uuid        16 bytes  binary uuid (or varint length and text if COMPACT_LITERAL_UUID). Only canonical uuids with
+ *                           lowercase hex digits are binary, so a uuid decodes exactly as it appears in the text response
+ *     puuid       16 bytes  parent uuid, device and service records only (same encoding as uuid)
+ *     devices     varint    RootDevice records only
+ *     services    varint    RootDevice and device records only
+ *     type        code      dictionary code of a well known type prefix, followed by the rest of the type as a string
+ *     st          code      COMPACT_ST_ROOTDEVICE, COMPACT_ST_UUID (uuid:uuid), COMPACT_ST_TYPE (same as type) or 
+ *                           COMPACT_ST_LITERAL followed by a string
+ *     name        string
+ *     location    code      COMPACT_LOC_SOURCE followed by varint port and path string, meaning http://source-ip:port/path
+ *                           where source-ip is the address the response came from, or COMPACT_LOC_LITERAL and a string
+ *  Strings are a varint length followed by the characters, without null termination. The fixed HTTP status line, 
+ *  CACHE-CONTROL header and header names are implied.
+ */
+
+#define COMPACT_MAGIC          0xC5
+#define COMPACT_VERSION        1
+#define COMPACT_LITERAL_UUID   0x01
+
+#define COMPACT_ST_LITERAL     0
+#define COMPACT_ST_ROOTDEVICE  1
+#define COMPACT_ST_UUID        2
+#define COMPACT_ST_TYPE        3
+
+#define COMPACT_LOC_LITERAL    0
+#define COMPACT_LOC_SOURCE     1
+
+typedef struct {
+  SSDPRecordKind  kind;
+  const char*     uuid;
+  const char*     puuid;              // Ignored for a RootDevice
+  const char*     type;
+  const char*     st;
+  const char*     name;
+  const char*     location;
+  int             numDevices;
+  int             numServices;
+} SSDPCompactFields;
+
+class SSDPCompact {
+  public:
+
+/**
+ *  encode() is part of the responder and decode() of the client (see SSDPConfig.h).
+ *  Encode fields into buffer, compressing location against ifc (the address the response is sent from). Returns the 
+ *  encoded length or 0 if buffer is too small.
+ */
+    static size_t    encode(uint8_t buffer[], size_t size, const SSDPCompactFields& fields, IPAddress ifc);
+
+/**
+ *  Decode packet, received from remote, into a new record in results if its ST matches ST. Returns the new record or NULL
+ *  if the packet is malformed, does not match, or does not fit.
+ */
+    static SSDPRecord* decode(const uint8_t packet[], size_t len, IPAddress remote, const char* ST, SSDPResponseSet& results);
+
+    static boolean   isCompact(const uint8_t packet[], size_t len)  {return (len > 2) && (packet[0] == COMPACT_MAGIC);}
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPCONFIG_H
+#define SSDPCONFIG_H
+
+/**
+ *  Build profiles. A device that only answers searches does not need the search client, and a controller that only
+ *  searches does not need the responder. Select a profile by defining SSDP_PROFILE for the whole build, for example 
+ *  with PlatformIO build_flags = -DSSDP_PROFILE=SSDP_PROFILE_RESPONDER. The Arduino IDE does not pass defines to
+ *  libraries, so IDE users change the default below.
+ *     SSDP_PROFILE_FULL       Responder and client (default)
+ *     SSDP_PROFILE_RESPONDER  SSDP::begin, doSSDP, replay and response statistics. No searchRequest, result sets,
+ *                             compact decoding or search packet templates.
+ *     SSDP_PROFILE_CLIENT     searchRequest and result sets. No responder state in the SSDP object, no type index,
+ *                             filters or response templates.
+ *  SSDP_RESPONDER and SSDP_CLIENT are derived from the profile and are what the sources test.
+ */
+#define SSDP_PROFILE_FULL       0
+#define SSDP_PROFILE_RESPONDER  1
+#define SSDP_PROFILE_CLIENT     2
+
+#ifndef SSDP_PROFILE
+#define SSDP_PROFILE SSDP_PROFILE_FULL
+#endif
+
+#if (SSDP_PROFILE != SSDP_PROFILE_FULL) && (SSDP_PROFILE != SSDP_PROFILE_RESPONDER) && (SSDP_PROFILE != SSDP_PROFILE_CLIENT)
+#error "SSDP_PROFILE must be SSDP_PROFILE_FULL, SSDP_PROFILE_RESPONDER or SSDP_PROFILE_CLIENT"
+#endif
+
+#define SSDP_RESPONDER  (SSDP_PROFILE != SSDP_PROFILE_CLIENT)
+#define SSDP_CLIENT     (SSDP_PROFILE != SSDP_PROFILE_RESPONDER)
+
+/**
+ *  Memory profiles. Every buffer size and capacity used by the library is set here. Select a preset with 
+ *  SSDP_MEMORY_PROFILE, or define any individual size for the build to override the preset:
+ *     SSDP_MEMORY_DEFAULT     Sizes the library has always used
+ *     SSDP_MEMORY_TINY        Smaller stack buffers and result sets for ESP8266 sketches short on RAM. Long display 
+ *                             names, locations or filters are truncated or rejected.
+ *     SSDP_MEMORY_HOST        Larger buffers, result sets and histograms for controllers with plenty of RAM
+ *  Sizes include null termination.
+ *     TXN_BUFFER_SIZE         Rendered response (on the stack)
+ *     SSDP_REQUEST_BUFFER_SIZE Request line and the headers the responder reads from a request (on the stack), other
+ *                             headers are discarded as the request is read
+ *     SSDP_BUFFER_SIZE        Search request packet and received response (on the stack during searchRequest)
+ *     ST_HEADER_SIZE          ST header value
+ *     ST_LSC_HEADER_SIZE      ST.LEELANAUSOFTWARE.COM header value
+ *     FILTER_HEADER_SIZE      FILTER.LEELANAUSOFTWARE.COM header value
+ *     SSDP_HEADER_BUFFER_SIZE Any other header value read from a response (USN, LOCATION, DESC)
+ *     ENC_HEADER_SIZE         ENC.LEELANAUSOFTWARE.COM header value
+ *     SINCE_HEADER_SIZE       SINCE.LEELANAUSOFTWARE.COM header value, a generation, the same in every preset
+ *     NTS_HEADER_SIZE         NTS header value of a proxy registration
+ *     PROXY_CACHE_SIZE        CACHE-CONTROL header value of a proxy registration
+ *     DESC_SIZE               Rendered DESC.LEELANAUSOFTWARE.COM value of a proxy registration, derived from SSDP_NAME_SIZE
+ *     BURST_LIST_SIZE         Missing record list of a burst re-request
+ *     SSDP_LOC_BUFFER_SIZE    Rendered device or service location
+ *     SSDP_PATH_SIZE          Handler path of a service
+ *     STATS_BUFFER_SIZE       Rendered SSDPStatsService JSON (on the stack)
+ *     SSDP_NAME_SIZE          Display name
+ *     SSDP_TYPE_SIZE          Device or service type
+ *     SSDP_UUID_SIZE          Device uuid, the same in every preset
+ *     SSDP_RESULT_CAPACITY    Default SSDPResponseSet arena capacity in bytes
+ *     SSDP_RESULT_STRINGS     Default SSDPResponseSet interned string count
+ *     SSDP_QUEUE_CAPACITY     Default SSDPHandlerQueue capacity in bytes, responses waiting for their handler
+ *     HISTOGRAM_BUCKETS       SSDPHistogram buckets, bucket i counts durations in [2^i,2^(i+1)) microseconds
+ *     SSDP_BURST_HOLD         ssdp:all bursts a responder holds for re-requests of lost records
+ *     SSDP_BURST_RECORDS      Largest burst a client tracks for lost records
+ *     SSDP_BURST_TRACKS       Bursts (one per responder) a client tracks during a search
+ *     SSDP_TIMERS             Timers that can be pending at once in the responder's timing wheel, held inline in SSDP
+ *     SSDP_TIMER_SLOTS        Slots of the timing wheel, a power of 2 and a multiple of 32
+ */
+#define SSDP_MEMORY_DEFAULT     0
+#define SSDP_MEMORY_TINY        1
+#define SSDP_MEMORY_HOST        2
+
+#ifndef SSDP_MEMORY_PROFILE
+#define SSDP_MEMORY_PROFILE SSDP_MEMORY_DEFAULT
+#endif
+
+#if SSDP_MEMORY_PROFILE == SSDP_MEMORY_TINY
+#define SSDP_PRESET(deflt,tiny,host) tiny
+#elif SSDP_MEMORY_PROFILE == SSDP_MEMORY_HOST
+#define SSDP_PRESET(deflt,tiny,host) host
+#elif SSDP_MEMORY_PROFILE == SSDP_MEMORY_DEFAULT
+#define SSDP_PRESET(deflt,tiny,host) deflt
+#else
+#error "SSDP_MEMORY_PROFILE must be SSDP_MEMORY_DEFAULT, SSDP_MEMORY_TINY or SSDP_MEMORY_HOST"
+#endif
+
+#ifndef TXN_BUFFER_SIZE
+#define TXN_BUFFER_SIZE          SSDP_PRESET(1536,768,1536)
+#endif
+#ifndef SSDP_REQUEST_BUFFER_SIZE
+#define SSDP_REQUEST_BUFFER_SIZE SSDP_PRESET(512,320,1024)
+#endif
+#ifndef SSDP_BUFFER_SIZE
+#define SSDP_BUFFER_SIZE         SSDP_PRESET(1000,512,1536)
+#endif
+#ifndef ST_HEADER_SIZE
+#define ST_HEADER_SIZE           SSDP_PRESET(100,72,256)
+#endif
+#ifndef ST_LSC_HEADER_SIZE
+#define ST_LSC_HEADER_SIZE       SSDP_PRESET(20,12,20)
+#endif
+#ifndef FILTER_HEADER_SIZE
+#define FILTER_HEADER_SIZE       SSDP_PRESET(160,96,256)
+#endif
+#ifndef SSDP_HEADER_BUFFER_SIZE
+#define SSDP_HEADER_BUFFER_SIZE  SSDP_PRESET(200,128,320)
+#endif
+#ifndef ENC_HEADER_SIZE
+#define ENC_HEADER_SIZE          SSDP_PRESET(16,12,16)
+#endif
+#ifndef SINCE_HEADER_SIZE
+#define SINCE_HEADER_SIZE        12
+#endif
+#ifndef NTS_HEADER_SIZE
+#define NTS_HEADER_SIZE          SSDP_PRESET(20,16,20)
+#endif
+#ifndef PROXY_CACHE_SIZE
+#define PROXY_CACHE_SIZE         SSDP_PRESET(24,20,32)
+#endif
+#ifndef BURST_LIST_SIZE
+#define BURST_LIST_SIZE          SSDP_PRESET(128,64,256)
+#endif
+#ifndef SSDP_LOC_BUFFER_SIZE
+#define SSDP_LOC_BUFFER_SIZE     SSDP_PRESET(128,96,256)
+#endif
+#ifndef SSDP_PATH_SIZE
+#define SSDP_PATH_SIZE           SSDP_PRESET(100,64,160)
+#endif
+#ifndef STATS_BUFFER_SIZE
+#define STATS_BUFFER_SIZE        SSDP_PRESET(1200,1200,1536)
+#endif
+#ifndef SSDP_NAME_SIZE
+#define SSDP_NAME_SIZE           SSDP_PRESET(32,24,64)
+#endif
+#ifndef SSDP_TYPE_SIZE
+#define SSDP_TYPE_SIZE           SSDP_PRESET(100,72,160)
+#endif
+#ifndef SSDP_UUID_SIZE
+#define SSDP_UUID_SIZE           40
+#endif
+#define DESC_SIZE                (SSDP_NAME_SIZE + SSDP_UUID_SIZE + 40)
+#ifndef SSDP_RESULT_CAPACITY
+#define SSDP_RESULT_CAPACITY     SSDP_PRESET(4096,1024,65536)
+#endif
+#ifndef SSDP_RESULT_STRINGS
+#define SSDP_RESULT_STRINGS      SSDP_PRESET(64,24,1024)
+#endif
+#ifndef SSDP_QUEUE_CAPACITY
+#define SSDP_QUEUE_CAPACITY      SSDP_PRESET(2048,1024,16384)
+#endif
+#ifndef HISTOGRAM_BUCKETS
+#define HISTOGRAM_BUCKETS        SSDP_PRESET(25,21,32)
+#endif
+#ifndef SSDP_BURST_HOLD
+#define SSDP_BURST_HOLD          SSDP_PRESET(2,1,8)
+#endif
+#ifndef SSDP_BURST_RECORDS
+#define SSDP_BURST_RECORDS       SSDP_PRESET(128,64,256)
+#endif
+#ifndef SSDP_BURST_TRACKS
+#define SSDP_BURST_TRACKS        SSDP_PRESET(8,4,32)
+#endif
+#ifndef SSDP_TIMERS
+#define SSDP_TIMERS              SSDP_PRESET(16,8,256)
+#endif
+#ifndef SSDP_TIMER_SLOTS
+#define SSDP_TIMER_SLOTS         SSDP_PRESET(64,32,512)
+#endif
+
+/**
+ *  Consistency checks. Fixed text is the longest template text around the variable fields: about 150 characters for a
+ *  search response and the M-SEARCH request (with its ENC header), and 45 characters for USN and DESC values around 
+ *  a uuid, type or name. A uuid is 36 characters.
+ */
+static_assert(ST_HEADER_SIZE >= 5+36+1,                       "ST_HEADER_SIZE must hold uuid:device-UUID");
+static_assert(ST_HEADER_SIZE >= SSDP_TYPE_SIZE,               "ST_HEADER_SIZE must hold a device or service type");
+static_assert(SSDP_UUID_SIZE >= 37,                           "SSDP_UUID_SIZE must hold a uuid");
+static_assert(ST_LSC_HEADER_SIZE >= 9,                        "ST_LSC_HEADER_SIZE must hold ssdp:all");
+static_assert(FILTER_HEADER_SIZE >= SSDP_NAME_SIZE + SSDP_TYPE_SIZE,
+                                                              "FILTER_HEADER_SIZE must hold a name and a service filter");
+static_assert(SSDP_HEADER_BUFFER_SIZE >= SSDP_LOC_BUFFER_SIZE, "SSDP_HEADER_BUFFER_SIZE must hold a LOCATION header");
+static_assert(SSDP_HEADER_BUFFER_SIZE >= 45 + SSDP_TYPE_SIZE,  "SSDP_HEADER_BUFFER_SIZE must hold a USN header");
+static_assert(SSDP_HEADER_BUFFER_SIZE >= 45 + SSDP_NAME_SIZE,  "SSDP_HEADER_BUFFER_SIZE must hold a DESC header");
+static_assert((ENC_HEADER_SIZE >= 10) && (ENC_HEADER_SIZE <= SSDP_HEADER_BUFFER_SIZE),
+                                                              "ENC_HEADER_SIZE must hold lsc-bin/1 and fit SSDP_HEADER_BUFFER_SIZE");
+static_assert((SINCE_HEADER_SIZE >= 11) && (SINCE_HEADER_SIZE <= SSDP_HEADER_BUFFER_SIZE),
+                                                              "SINCE_HEADER_SIZE must hold a generation and fit SSDP_HEADER_BUFFER_SIZE");
+static_assert((NTS_HEADER_SIZE >= 15) && (NTS_HEADER_SIZE <= SSDP_HEADER_BUFFER_SIZE),
+                                                              "NTS_HEADER_SIZE must hold lsc:unregister and fit SSDP_HEADER_BUFFER_SIZE");
+static_assert((PROXY_CACHE_SIZE >= 20) && (PROXY_CACHE_SIZE <= SSDP_HEADER_BUFFER_SIZE),
+                                                              "PROXY_CACHE_SIZE must hold max-age = 86400 and fit SSDP_HEADER_BUFFER_SIZE");
+static_assert(DESC_SIZE <= SSDP_HEADER_BUFFER_SIZE,          "SSDP_HEADER_BUFFER_SIZE must hold the DESC of a proxy registration");
+static_assert((BURST_LIST_SIZE >= 16) && (BURST_LIST_SIZE + 32 <= SSDP_HEADER_BUFFER_SIZE),
+                                                              "BURST_LIST_SIZE and the burst id must fit SSDP_HEADER_BUFFER_SIZE");
+static_assert(SSDP_BUFFER_SIZE >= 150 + ST_HEADER_SIZE + SSDP_HEADER_BUFFER_SIZE,
+                                                              "SSDP_BUFFER_SIZE must hold a search request with a BURST or SINCE header");
+static_assert(SSDP_LOC_BUFFER_SIZE >= 28 + SSDP_PATH_SIZE,   "SSDP_LOC_BUFFER_SIZE must hold http://address:port and a handler path");
+static_assert(STATS_BUFFER_SIZE >= 1200,                      "STATS_BUFFER_SIZE must hold every section of the stats JSON");
+static_assert(SSDP_BUFFER_SIZE >= 150 + ST_HEADER_SIZE + FILTER_HEADER_SIZE,
+                                                              "SSDP_BUFFER_SIZE must hold a search request with a filter");
+static_assert(SSDP_REQUEST_BUFFER_SIZE >= 150 + ST_HEADER_SIZE + FILTER_HEADER_SIZE,
+                                                              "SSDP_REQUEST_BUFFER_SIZE must hold a search request with a filter");
+static_assert(SSDP_BUFFER_SIZE >= 3*SSDP_HEADER_BUFFER_SIZE,  "SSDP_BUFFER_SIZE must hold a search response");
+static_assert(TXN_BUFFER_SIZE >= 150 + SSDP_LOC_BUFFER_SIZE + ST_HEADER_SIZE + 2*36 + SSDP_TYPE_SIZE + SSDP_NAME_SIZE,
+                                                              "TXN_BUFFER_SIZE must hold a search response");
+static_assert((HISTOGRAM_BUCKETS >= 8) && (HISTOGRAM_BUCKETS <= 32), "HISTOGRAM_BUCKETS must be between 8 and 32");
+static_assert(SSDP_BURST_HOLD >= 1,                           "SSDP_BURST_HOLD must be at least 1");
+static_assert((SSDP_BURST_RECORDS % 8) == 0,                  "SSDP_BURST_RECORDS must be a multiple of 8");
+static_assert((SSDP_TIMERS >= 1) && (SSDP_TIMERS <= 1024),   "SSDP_TIMERS must be between 1 and 1024, the pool is held inline in SSDP");
+static_assert(((SSDP_TIMER_SLOTS & (SSDP_TIMER_SLOTS - 1)) == 0) && ((SSDP_TIMER_SLOTS % 32) == 0),
+                                                              "SSDP_TIMER_SLOTS must be a power of 2 and a multiple of 32");
+static_assert(SSDP_QUEUE_CAPACITY >= SSDP_BUFFER_SIZE + 3,   "SSDP_QUEUE_CAPACITY must hold a response of SSDP_BUFFER_SIZE");
+static_assert((SSDP_RESULT_STRINGS >= 2) && (SSDP_RESULT_STRINGS < 0x7FFF), "SSDP_RESULT_STRINGS must be between 2 and 32766");
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPFilter.h"
+#include "SSDPTypeIndex.h"
+#include "SSDPConfig.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+const char FILTER_NAME[]    PROGMEM = "name";
+const char FILTER_SERVICE[] PROGMEM = "service";
+const char FILTER_DEPTH[]   PROGMEM = "depth";
+
+void SSDPFilter::clear() {
+  _name[0]    = '\0';
+  _service[0] = '\0';
+  _depth      = -1;
+  _empty      = true;
+  _valid      = true;
+}
+
+boolean SSDPFilter::compile(const char* expr) {
+  clear();
+  const char* start = expr;
+  while( *start != '\0' ) {
+    while( *start == ' ' ) start++;
+    const char* end = strchr(start,';');
+    if( end == NULL ) end = start + strlen(start);
+    const char* eq = (const char*)memchr(start,'=',end-start);
+    if( eq != NULL ) {
+      const char* valueEnd = end;
+      while( (valueEnd > eq+1) && (*(valueEnd-1) == ' ') ) valueEnd--;
+      _valid = term(start,eq-start,eq+1,valueEnd-(eq+1));
+    }
+    else {
+      const char* blank = start;
+      while( (blank < end) && (*blank == ' ') ) blank++;
+      _valid = (blank == end);                         // Only an empty term may omit '='
+    }
+    if( !_valid ) break;
+    start = ((*end == ';')?(end+1):(end));
+  }
+  return _valid;
+}
+
+boolean SSDPFilter::term(const char* key, size_t keyLen, const char* value, size_t valueLen) {
+  boolean result = true;
+  if( (keyLen == strlen_P(FILTER_NAME)) && (strncmp_P(key,FILTER_NAME,keyLen) == 0) && (valueLen < FILTER_NAME_SIZE) ) {
+    memcpy(_name,value,valueLen);
+    _name[valueLen] = '\0';
+  }
+  else if( (keyLen == strlen_P(FILTER_SERVICE)) && (strncmp_P(key,FILTER_SERVICE,keyLen) == 0) && (valueLen < FILTER_TYPE_SIZE) && (valueLen > 0) ) {
+    memcpy(_service,value,valueLen);
+    _service[valueLen] = '\0';
+  }
+  else if( (keyLen == strlen_P(FILTER_DEPTH)) && (strncmp_P(key,FILTER_DEPTH,keyLen) == 0) && (valueLen > 0) && (valueLen < 4) ) {
+    _depth = 0;
+    for( size_t i=0; (i<valueLen) && result; i++ ) {
+      if( isdigit(value[i]) ) _depth = 10*_depth + (value[i]-'0');
+      else result = false;
+    }
+  }
+  else result = false;
+  if( result ) _empty = false;
+  return result;
+}
+
+/**
+ *  Node terms, evaluated on the name and depth of a provider node
+ */
+boolean SSDPFilter::matches(const char* name, int depth) const {
+  if( !_valid ) return false;
+  if( _empty ) return true;
+  if( (_name[0] != '\0') && (strncmp(name,_name,strlen(_name)) != 0) ) return false;
+  if( (_depth >= 0) && (depth > _depth) ) return false;
+  return true;
+}
+
+boolean SSDPFilter::matchesService(const char* type) const {
+  return (_service[0] == '\0') || SSDPTypeIndex::matches(_service,type);
+}
+
+} // End of namespace lsc
+
+#endif
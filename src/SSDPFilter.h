@@ -0,0 +1,72 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPFILTER_H
+#define SSDPFILTER_H
+
+#include <Arduino.h>
+#include <ctype.h>
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define FILTER_NAME_SIZE   SSDP_NAME_SIZE
+#define FILTER_TYPE_SIZE   SSDP_TYPE_SIZE
+
+/**
+ *  Search filter carried in the FILTER.LEELANAUSOFTWARE.COM request header and evaluated by the responder on each device 
+ *  and service before its response is rendered, so nodes that do not match send nothing. The filter expression is a list 
+ *  of terms separated by ';', all of which must match:
+ *     name=prefix          Display name starts with prefix
+ *     service=type         A device hosts a service whose type matches type, or a service has type type. type may be a
+ *                          pattern containing '*'
+ *     depth=n              Node depth is at most n, where a RootDevice is depth 0, an embedded device is depth 1, and a 
+ *                          service is one deeper than its device
+ *  For example: name=Kitchen;depth=0 or service=urn:LEELANAUSOFTWARE-com:service:GetDateTime:*
+ */
+class SSDPFilter {
+  public:
+    SSDPFilter()                                       {clear();}
+
+    boolean      compile(const char* expr);           // Compile expr, returns false (and matches nothing) if expr is malformed
+    void         clear();                             // Remove all terms, an empty filter matches everything
+    boolean      isEmpty()                  const     {return _empty;}
+    boolean      hasServiceTerm()           const     {return _service[0] != '\0';}
+    boolean      matches(const char* name, int depth) const;   // name and depth terms only
+    boolean      matchesService(const char* type)     const;   // service term only, true if there is no service term
+
+  private:
+    char         _name[FILTER_NAME_SIZE];
+    char         _service[FILTER_TYPE_SIZE];
+    int          _depth;                              // Maximum depth, -1 for any
+    boolean      _empty;
+    boolean      _valid;
+
+    boolean      term(const char* key, size_t keyLen, const char* value, size_t valueLen);
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,150 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#include "SSDPHandlerQueue.h"
+
+#if SSDP_CLIENT
+
+namespace lsc {
+
+/**
+ *  Each entry is its length (uint16_t) followed by the response text and its null termination, so the handler is
+ *  given a UPnPBuffer over the ring itself. An entry is never split; if it does not fit above the last entry it is
+ *  written at the start of the ring, and the space left above is skipped.
+ */
+#define ENTRY_SIZE(len)  (sizeof(uint16_t) + (len) + 1)
+
+SSDPHandlerQueue::SSDPHandlerQueue(SSDPHandler handler, SSDPBackpressure policy, size_t capacity) : _handler(handler), _policy(policy) {
+  _ring = (uint8_t*)malloc(capacity);
+  _capacity = ((_ring != NULL)?(capacity):(0));
+  _end = _capacity;
+}
+
+SSDPHandlerQueue::~SSDPHandlerQueue() {
+  if( _ring != NULL ) free(_ring);
+}
+
+boolean SSDPHandlerQueue::push(const char* packet, int len) {
+  if( len < 0 ) len = 0;
+  if( len > 0xFFFF ) len = 0xFFFF;
+  size_t need = ENTRY_SIZE(len);
+  size_t at   = 0;
+  if( need > _capacity ) {                       // Could never fit, so drop it without touching waiting responses
+    _stats.dropped++;
+    return false;
+  }
+  boolean fits = reserve(need,at);
+  while( !fits && (_count > 0) && (_policy != SSDP_DROP_NEWEST) ) {
+    if( _policy == SSDP_RUN_INLINE ) {
+      runHead();
+      _stats.inlined++;
+    }
+    else {
+      pop();
+      _stats.dropped++;
+    }
+    fits = reserve(need,at);
+  }
+  if( !fits ) {
+    _stats.dropped++;
+    return false;
+  }
+  uint16_t l = len;
+  memcpy(_ring+at,&l,sizeof(l));
+  memcpy(_ring+at+sizeof(l),packet,len);
+  _ring[at+sizeof(l)+len] = '\0';
+  _tail = at + need;
+  _count++;
+  _stats.queued++;
+  if( _count > _stats.highWater ) _stats.highWater = _count;
+  return true;
+}
+
+int SSDPHandlerQueue::dispatch(int max) {
+  int result = 0;
+  while( (_count > 0) && ((max < 0) || (result < max)) ) {
+    runHead();
+    _stats.handled++;
+    result++;
+  }
+  return result;
+}
+
+void SSDPHandlerQueue::clear() {
+  _head    = 0;
+  _tail    = 0;
+  _end     = _capacity;
+  _wrapped = false;
+  _count   = 0;
+}
+
+void SSDPHandlerQueue::resetStats() {
+  _stats = {0,0,0,0,0};
+}
+
+/**
+ *  Find need contiguous bytes for an entry at _tail, or at the start of the ring below _head
+ */
+boolean SSDPHandlerQueue::reserve(size_t need, size_t& at) {
+  if( _count == 0 ) clear();
+  if( _wrapped ) {
+    at = _tail;
+    return (_tail + need <= _head);
+  }
+  if( _tail + need <= _capacity ) {
+    at = _tail;
+    return true;
+  }
+  if( need <= _head ) {
+    _end     = _tail;
+    _wrapped = true;
+    at       = 0;
+    return true;
+  }
+  return false;
+}
+
+void SSDPHandlerQueue::pop() {
+  uint16_t len;
+  memcpy(&len,_ring+_head,sizeof(len));
+  _head += ENTRY_SIZE(len);
+  if( _wrapped && (_head >= _end) ) {
+    _head    = 0;
+    _end     = _capacity;
+    _wrapped = false;
+  }
+  if( --_count == 0 ) clear();
+}
+
+/**
+ *  The entry stays in the ring while its handler runs and is removed after
+ */
+void SSDPHandlerQueue::runHead() {
+  UPnPBuffer b((const char*)(_ring+_head+sizeof(uint16_t)));
+  if( _handler ) _handler(&b);
+  pop();
+}
+
+} // End of namespace lsc
+
+#endif
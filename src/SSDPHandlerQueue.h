@@ -0,0 +1,105 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#ifndef SSDPHANDLERQUEUE_H
+#define SSDPHANDLERQUEUE_H
+
+#include <Arduino.h>
+#include "UPnPBuffer.h"
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+typedef std::function<void(UPnPBuffer*)> SSDPHandler;
+
+/**
+ *  What SSDPHandlerQueue::push does with a response that does not fit:
+ *     SSDP_DROP_NEWEST  - Drop the response
+ *     SSDP_DROP_OLDEST  - Drop the oldest waiting responses until it fits
+ *     SSDP_RUN_INLINE   - Run the handler on the oldest waiting responses until it fits, stalling the receive loop
+ *                         as an inline handler would, but losing nothing
+ *  A response larger than the whole queue is dropped under every policy.
+ */
+typedef enum {
+  SSDP_DROP_NEWEST = 0,
+  SSDP_DROP_OLDEST = 1,
+  SSDP_RUN_INLINE  = 2
+} SSDPBackpressure;
+
+typedef struct {
+  uint32_t      queued;                  // Responses pushed
+  uint32_t      handled;                 // Responses handed to the handler by dispatch()
+  uint32_t      inlined;                 // Responses handed to the handler by push() under SSDP_RUN_INLINE
+  uint32_t      dropped;                 // Responses dropped by the backpressure policy
+  int           highWater;               // Most responses waiting at once
+} SSDPQueueStats;
+
+/**
+ *  Bounded queue of search responses waiting for their handler. The receive loop only checks a response (ST and DESC
+ *  headers, as for searchRequest with a handler) and copies it into a ring buffer of fixed capacity allocated on 
+ *  construction; the handler runs later from dispatch(), so slow handlers do not hold up reading the channel.
+ *  Responses that do not fit are handled by the backpressure policy and counted in stats().
+ *  A handler must not search with its own queue.
+ */
+class SSDPHandlerQueue {
+  public:
+    SSDPHandlerQueue(SSDPHandler handler, SSDPBackpressure policy = SSDP_DROP_NEWEST, size_t capacity = SSDP_QUEUE_CAPACITY);
+    ~SSDPHandlerQueue();
+
+    boolean       push(const char* packet, int len);   // Returns false if the response was dropped
+    int           dispatch(int max = -1);              // Run the handler on up to max waiting responses (all if max < 0), returns the number run
+    int           size()                     const    {return _count;}
+    boolean       isEmpty()                  const    {return _count == 0;}
+    size_t        capacity()                 const    {return _capacity;}
+    void          clear();                             // Drop waiting responses without counting them
+    SSDPBackpressure policy()                const    {return _policy;}
+    void          policy(SSDPBackpressure p)           {_policy = p;}
+    const SSDPQueueStats& stats()            const    {return _stats;}
+    void          resetStats();
+
+  private:
+    SSDPHandler      _handler;
+    SSDPBackpressure _policy;
+    uint8_t*         _ring     = NULL;
+    size_t           _capacity = 0;
+    size_t           _head     = 0;        // Oldest entry
+    size_t           _tail     = 0;        // Where the next entry is written
+    size_t           _end      = 0;        // End of the entries above _head when _wrapped
+    boolean          _wrapped  = false;    // Entries continue at the start of the ring, below _head
+    int              _count    = 0;
+    SSDPQueueStats   _stats    = {0,0,0,0,0};
+
+    boolean          reserve(size_t need, size_t& at);
+    void             pop();
+    void             runHead();
+
+    SSDPHandlerQueue(const SSDPHandlerQueue&)            = delete;
+    SSDPHandlerQueue& operator=(const SSDPHandlerQueue&) = delete;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,46 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPHeaders.h"
+
+namespace lsc {
+
+const char ST_LSC_HEADER[]     PROGMEM = SSDP_LSC_ST;
+const char DESC_LSC_HEADER[]   PROGMEM = SSDP_LSC_DESC;
+const char FILTER_LSC_HEADER[] PROGMEM = SSDP_LSC_FILTER;
+const char ENC_LSC_HEADER[]    PROGMEM = SSDP_LSC_ENC;
+const char SINCE_LSC_HEADER[]  PROGMEM = SSDP_LSC_SINCE;
+const char SYNC_LSC_HEADER[]   PROGMEM = SSDP_LSC_SYNC;
+const char BURST_LSC_HEADER[]  PROGMEM = SSDP_LSC_BURST;
+const char TOKEN_LSC_HEADER[]  PROGMEM = SSDP_LSC_TOKEN;
+
+const char SYNC_GENERATION[]   PROGMEM = SSDP_SYNC_GENERATION;
+const char SYNC_DELTA[]        PROGMEM = SSDP_SYNC_DELTA;
+const char SYNC_FULL[]         PROGMEM = SSDP_SYNC_FULL;
+const char SYNC_REMOVED[]      PROGMEM = SSDP_SYNC_REMOVED;
+
+const char BURST_ID[]          PROGMEM = SSDP_BURST_ID;
+const char BURST_INDEX[]       PROGMEM = SSDP_BURST_INDEX;
+const char BURST_TOTAL[]       PROGMEM = SSDP_BURST_TOTAL;
+const char BURST_MISSING[]     PROGMEM = SSDP_BURST_MISSING;
+
+} // End of namespace lsc
@@ -0,0 +1,85 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPHEADERS_H
+#define SSDPHEADERS_H
+
+#include <Arduino.h>
+
+/**
+ *  Wire tokens of the LEELANAUSOFTWARE.COM extension headers. The literals are macros so that message templates can 
+ *  be built from them by the preprocessor; the PROGMEM copies below are defined once in SSDPHeaders.cpp for parsing.
+ *     SSDP_LSC_ST        ssdp:all (or empty) on a search request
+ *     SSDP_LSC_DESC      Device hierarchy on a search response or proxy registration
+ *     SSDP_LSC_FILTER    Search filter (see SSDPFilter.h)
+ *     SSDP_LSC_ENC       Response encoding (see SSDPCompact.h)
+ *     SSDP_LSC_SINCE     Generation a delta sync request starts from
+ *     SSDP_LSC_SYNC      :generation:G:delta:, :generation:G:full: or :generation:G:removed: on a delta sync response
+ *     SSDP_LSC_BURST     :id:burst-id:index:i:total:n: on a response, :id:burst-id:missing:list: on a re-request
+ *     SSDP_LSC_TOKEN     Registrant of a proxy registration
+ */
+#define SSDP_LSC_ST             "ST.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_DESC           "DESC.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_FILTER         "FILTER.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_ENC            "ENC.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_SINCE          "SINCE.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_SYNC           "SYNC.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_BURST          "BURST.LEELANAUSOFTWARE.COM"
+#define SSDP_LSC_TOKEN          "TOKEN.LEELANAUSOFTWARE.COM"
+
+#define SSDP_SYNC_GENERATION    ":generation:"
+#define SSDP_SYNC_DELTA         "delta"
+#define SSDP_SYNC_FULL          "full"
+#define SSDP_SYNC_REMOVED       "removed"
+
+#define SSDP_BURST_ID           ":id:"
+#define SSDP_BURST_INDEX        ":index:"
+#define SSDP_BURST_TOTAL        ":total:"
+#define SSDP_BURST_MISSING      ":missing:"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+extern const char ST_LSC_HEADER[]     PROGMEM;
+extern const char DESC_LSC_HEADER[]   PROGMEM;
+extern const char FILTER_LSC_HEADER[] PROGMEM;
+extern const char ENC_LSC_HEADER[]    PROGMEM;
+extern const char SINCE_LSC_HEADER[]  PROGMEM;
+extern const char SYNC_LSC_HEADER[]   PROGMEM;
+extern const char BURST_LSC_HEADER[]  PROGMEM;
+extern const char TOKEN_LSC_HEADER[]  PROGMEM;
+
+extern const char SYNC_GENERATION[]   PROGMEM;
+extern const char SYNC_DELTA[]        PROGMEM;
+extern const char SYNC_FULL[]         PROGMEM;
+extern const char SYNC_REMOVED[]      PROGMEM;
+
+extern const char BURST_ID[]          PROGMEM;
+extern const char BURST_INDEX[]       PROGMEM;
+extern const char BURST_TOTAL[]       PROGMEM;
+extern const char BURST_MISSING[]     PROGMEM;
+
+} // End of namespace lsc
+
+#endif
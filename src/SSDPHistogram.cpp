@@ -0,0 +1,71 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPHistogram.h"
+
+namespace lsc {
+
+void SSDPHistogram::record(uint32_t micros) {
+  int bucket = 0;
+  uint32_t v = micros >> 1;
+  while( (v > 0) && (bucket < HISTOGRAM_BUCKETS-1) ) {v >>= 1; bucket++;}
+  _buckets[bucket]++;
+  _count++;
+  _sum += micros;
+  if( micros > _max ) _max = micros;
+}
+
+void SSDPHistogram::reset() {
+  memset(_buckets,0,sizeof(_buckets));
+  _count = 0;
+  _max   = 0;
+  _sum   = 0;
+}
+
+uint32_t SSDPHistogram::percentile(int pct) const {
+  uint32_t result = 0;
+  if( _count > 0 ) {
+    if( pct < 0 ) pct = 0;
+    if( pct > 100 ) pct = 100;
+
+/**
+ *  rank is the 1-based position of the requested sample, walk buckets until it is covered
+ */
+    uint32_t rank = (uint32_t)(((uint64_t)_count * pct + 99)/100);
+    if( rank == 0 ) rank = 1;
+    uint32_t seen = 0;
+    result = _max;
+    for( int i=0; i<HISTOGRAM_BUCKETS; i++ ) {
+      seen += _buckets[i];
+      if( seen >= rank ) {
+        if( i < HISTOGRAM_BUCKETS-1 ) {
+          uint32_t upper = (((uint32_t)2) << i) - 1;
+          if( upper < result ) result = upper;
+        }
+        break;
+      }
+    }
+  }
+  return result;
+}
+
+} // End of namespace lsc
@@ -0,0 +1,62 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPHISTOGRAM_H
+#define SSDPHISTOGRAM_H
+
+#include <Arduino.h>
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+// HISTOGRAM_BUCKETS is set in SSDPConfig.h. Bucket i counts samples in [2^i,2^(i+1)) microseconds, the last bucket is open ended
+
+/**
+ *  Log bucketed histogram of durations in microseconds. Recording is constant time and the histogram has a fixed
+ *  size, so it can be kept for the life of the responder. Percentiles are reported as the upper bound of the bucket 
+ *  holding the requested sample, capped at the largest sample recorded, so they overstate by at most a factor of 2.
+ */
+class SSDPHistogram {
+  public:
+    SSDPHistogram()                                   {reset();}
+
+    void          record(uint32_t micros);          // Add a sample
+    void          reset();                          // Remove all samples
+    uint32_t      count()                const      {return _count;}
+    uint32_t      max()                  const      {return _max;}
+    uint32_t      mean()                 const      {return ((_count>0)?((uint32_t)(_sum/_count)):(0));}
+    uint32_t      percentile(int pct)    const;     // Duration in microseconds at or below which pct percent of samples fall
+    uint32_t      bucketCount(int i)     const      {return (((i>=0)&&(i<HISTOGRAM_BUCKETS))?(_buckets[i]):(0));}
+
+  private:
+    uint32_t      _buckets[HISTOGRAM_BUCKETS];
+    uint32_t      _count;
+    uint32_t      _max;
+    uint64_t      _sum;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,160 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPNodeProvider.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+void SSDPRootDeviceProvider::deviceNode(UPnPDevice* d, SSDPNode& node) {
+  RootDevice* r = d->asRootDevice();
+  UPnPDevice* p = d->parentAsDevice();
+
+/**
+ *  A device that is neither a RootDevice nor has a parent is an error state, and is reported as a RootDevice
+ */
+  node.kind        = (((r == NULL) && (p != NULL))?(SSDP_DEVICE_RECORD):(SSDP_ROOT_RECORD));
+  node.uuid        = d->uuid();
+  node.puuid       = ((p != NULL)?(p->uuid()):(""));
+  node.type        = d->getType();
+  node.name        = d->getDisplayName();
+  node.numDevices  = ((r != NULL)?(r->numDevices()):(0));
+  node.numServices = d->numServices();
+  node.depth       = ((p != NULL)?(1):(0));
+  node.ref         = d;
+}
+
+boolean SSDPRootDeviceProvider::serviceNode(UPnPService* s, SSDPNode& node) {
+  UPnPDevice* p = s->parentAsDevice();
+  if( p == NULL ) return false;
+  node.kind        = SSDP_SERVICE_RECORD;
+  node.uuid        = p->uuid();
+  node.puuid       = p->uuid();
+  node.type        = s->getType();
+  node.name        = s->getDisplayName();
+  node.numDevices  = 0;
+  node.numServices = 0;
+  node.depth       = ((p->parentAsDevice() != NULL)?(2):(1));
+  node.ref         = s;
+  return true;
+}
+
+void SSDPRootDeviceProvider::roots(SSDPNodeHandler handler) {
+  if( _root == NULL ) return;
+  SSDPNode node;
+  deviceNode(_root,node);
+  handler(node);
+}
+
+/**
+ *  An index larger than limit is not built, and searches walk the device tree instead
+ */
+boolean SSDPRootDeviceProvider::reindex(size_t limit) {
+  if( (_root != NULL) && (SSDPTypeIndex::memoryRequired(_root) > limit) ) {
+    _index.clear();
+    return false;
+  }
+  return _index.build(_root);
+}
+
+boolean SSDPRootDeviceProvider::find(const char* uuid, SSDPNode& node) {
+  UPnPDevice* d = ((_root != NULL)?(_root->getDevice(uuid)):(NULL));
+  if( d != NULL ) deviceNode(d,node);
+  return (d != NULL);
+}
+
+void SSDPRootDeviceProvider::children(const SSDPNode& node, SSDPNodeHandler handler) {
+  if( node.kind == SSDP_SERVICE_RECORD ) return;
+  UPnPDevice* d = (UPnPDevice*)node.ref;
+  SSDPNode child;
+  UPnPService** services = d->services();
+  for( int i=0; i<d->numServices(); i++ ) {
+    if( serviceNode(services[i],child) ) handler(child);
+  }
+  RootDevice* r = d->asRootDevice();
+  if( r != NULL ) {
+    UPnPDevice** devices = r->devices();
+    for( int i=0; i<r->numDevices(); i++ ) {
+      deviceNode(devices[i],child);
+      handler(child);
+    }
+  }
+}
+
+int SSDPRootDeviceProvider::match(const char* pattern, SSDPNodeHandler handler) {
+  if( _root == NULL ) return 0;
+  if( _index.isBuilt() ) {
+    return _index.match(pattern,[handler](UPnPDevice* device, UPnPService* service) {
+      SSDPNode node;
+      if( device != NULL ) {
+        deviceNode(device,node);
+        handler(node);
+      }
+      else if( serviceNode(service,node) ) handler(node);
+    });
+  }
+  return matchTree(_root,pattern,handler);
+}
+
+int SSDPRootDeviceProvider::matchTree(UPnPDevice* d, const char* pattern, SSDPNodeHandler handler) {
+  int result = 0;
+  boolean glob = (strchr(pattern,'*') != NULL);
+  SSDPNode node;
+  if( (glob)?(SSDPTypeIndex::matches(pattern,d->getType())):(d->isType(pattern)) ) {
+    deviceNode(d,node);
+    handler(node);
+    result++;
+  }
+  UPnPService** services = d->services();
+  for( int i=0; i<d->numServices(); i++ ) {
+    boolean match = ((glob)?(SSDPTypeIndex::matches(pattern,services[i]->getType())):(services[i]->isType(pattern)));
+    if( match && serviceNode(services[i],node) ) {
+      handler(node);
+      result++;
+    }
+  }
+  RootDevice* r = d->asRootDevice();
+  if( r != NULL ) {
+    UPnPDevice** devices = r->devices();
+    for( int i=0; i<r->numDevices(); i++ ) result += matchTree(devices[i],pattern,handler);
+  }
+  return result;
+}
+
+/**
+ *  RootDevice location does not include the root target, so will default to RootDevice::displayRoot
+ */
+void SSDPRootDeviceProvider::location(const SSDPNode& node, char buffer[], size_t size, IPAddress ifc) {
+  buffer[0] = '\0';
+  if( node.kind == SSDP_SERVICE_RECORD ) ((UPnPService*)node.ref)->location(buffer,size,ifc);
+  else {
+    UPnPDevice* d = (UPnPDevice*)node.ref;
+    RootDevice* r = d->asRootDevice();
+    if( r != NULL ) r->rootLocation(buffer,size,ifc);
+    else d->location(buffer,size,ifc);
+  }
+}
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPNODEPROVIDER_H
+#define SSDPNODEPROVIDER_H
+
+#include <Arduino.h>
+#include <UPnPDevice.h>
+#include "SSDPConfig.h"
+#include "SSDPResponseSet.h"
+#include "SSDPTypeIndex.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  A device or service as seen by the responder. Strings belong to the provider and must stay valid while the provider
+ *  is unchanged. For a service, uuid is the uuid of its device (as in the service USN).
+ */
+typedef struct SSDPNode {
+  SSDPRecordKind  kind;
+  const char*     uuid;
+  const char*     puuid;                 // Parent device uuid, "" for a RootDevice
+  const char*     type;
+  const char*     name;
+  int             numDevices;            // Embedded devices of a RootDevice
+  int             numServices;           // Services of a device
+  int             depth;                 // RootDevice 0, embedded device 1, services one deeper than their device
+  const void*     ref;                   // Provider handle for the node
+} SSDPNode;
+
+typedef std::function<void(const SSDPNode&)> SSDPNodeHandler;
+
+/**
+ *  Source of the nodes a responder answers for. The responder never walks device objects itself, so a provider can
+ *  serve a tree from UPnPDevice objects (SSDPRootDeviceProvider), from a table of bridged endpoints, or from storage,
+ *  without creating a UPnPDevice or UPnPService per node. 
+ *     roots     - Call handler on each RootDevice
+ *     find      - Fill node with the RootDevice or embedded device with uuid, returns false if there is none
+ *     children  - Call handler on each service of node, then each embedded device if node is a RootDevice
+ *     match     - Call handler on each device and service whose type matches pattern (see SSDPTypeIndex::matches),
+ *                 returns the number of matches
+ *     location  - Render the LOCATION of node as seen from the network interface ifc
+ */
+class SSDPNodeProvider {
+  public:
+    virtual ~SSDPNodeProvider() {}
+
+    virtual void     roots(SSDPNodeHandler handler)                                                 = 0;
+    virtual boolean  find(const char* uuid, SSDPNode& node)                                         = 0;
+    virtual void     children(const SSDPNode& node, SSDPNodeHandler handler)                        = 0;
+    virtual int      match(const char* pattern, SSDPNodeHandler handler)                            = 0;
+    virtual void     location(const SSDPNode& node, char buffer[], size_t size, IPAddress ifc)      = 0;
+};
+
+/**
+ *  Node provider over a RootDevice and its UPnPDevice and UPnPService objects. Type searches use an SSDPTypeIndex 
+ *  when one is built (see reindex), otherwise the device tree is walked.
+ */
+class SSDPRootDeviceProvider : public SSDPNodeProvider {
+  public:
+    SSDPRootDeviceProvider() {}
+
+    void             setRoot(RootDevice* root)                  {_root = root; _index.clear();}
+    RootDevice*      root()                         const       {return _root;}
+    boolean          reindex(size_t limit = SIZE_MAX);          // Returns false if the index could not be built within limit bytes
+    const SSDPTypeIndex& index()                    const       {return _index;}
+
+    void             roots(SSDPNodeHandler handler);
+    boolean          find(const char* uuid, SSDPNode& node);
+    void             children(const SSDPNode& node, SSDPNodeHandler handler);
+    int              match(const char* pattern, SSDPNodeHandler handler);
+    void             location(const SSDPNode& node, char buffer[], size_t size, IPAddress ifc);
+
+    static void      deviceNode(UPnPDevice* d, SSDPNode& node);
+    static boolean   serviceNode(UPnPService* s, SSDPNode& node);   // Returns false if s has no parent device
+
+  private:
+    RootDevice*      _root = NULL;
+    SSDPTypeIndex    _index;
+
+    int              matchTree(UPnPDevice* d, const char* pattern, SSDPNodeHandler handler);
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,327 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPProxy.h"
+#include "SSDPHeaders.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+const char PROXY_USN_HEADER[]      PROGMEM = "USN";
+const char PROXY_LOCATION_HEADER[] PROGMEM = "LOCATION";
+const char PROXY_CACHE_HEADER[]    PROGMEM = "CACHE-CONTROL";
+const char PROXY_MAX_AGE[]         PROGMEM = "max-age";
+const char PROXY_UUID_PREFIX[]     PROGMEM = "uuid:";
+const char PROXY_DELIM[]           PROGMEM = "::";
+
+boolean SSDPProxy::begin(int capacity) {
+  end();
+  if( capacity > 0 ) _entries = new(std::nothrow) SSDPProxyEntry[capacity];
+  if( _entries != NULL ) {
+    _capacity = capacity;
+    for( int i=0; i<_capacity; i++ ) _entries[i].ttl = 0;
+  }
+  return (_entries != NULL);
+}
+
+void SSDPProxy::end() {
+  if( _entries != NULL ) delete[] _entries;
+  _entries  = NULL;
+  _capacity = 0;
+  _dropped  = 0;
+  _rejected = 0;
+}
+
+int SSDPProxy::size() const {
+  int result = 0;
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) if( isLive(&_entries[i],now) ) result++;
+  return result;
+}
+
+void SSDPProxy::copy(char dst[], size_t size, const char* src, size_t len) {
+  if( src == NULL ) len = 0;
+  if( len >= size ) len = size - 1;
+  if( len > 0 ) memcpy(dst,src,len);
+  dst[len] = '\0';
+}
+
+boolean SSDPProxy::owns(const char* uuid, uint32_t owner) const {
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) {
+    const SSDPProxyEntry* e = &_entries[i];
+    if( isLive(e,now) && (strcmp(e->uuid,uuid) == 0) && (e->owner != owner) ) return false;
+  }
+  return true;
+}
+
+/**
+ *  Keys are an FNV-1a hash of the token, or of the four address bytes following a 0 byte (which a token never holds)
+ */
+uint32_t SSDPProxy::ownerKey(UPnPBuffer* b, IPAddress remoteAddr) {
+  char     token[SSDP_HEADER_BUFFER_SIZE];
+  uint32_t result = 2166136261UL;
+  token[0] = '\0';
+  if( b->headerValue_P(TOKEN_LSC_HEADER,token,SSDP_HEADER_BUFFER_SIZE) && (token[0] != '\0') ) {
+    for( const char* p = token; *p != '\0'; p++ ) {result ^= (uint8_t)*p; result *= 16777619UL;}
+  }
+  else {
+    result *= 16777619UL;
+    for( int i=0; i<4; i++ ) {result ^= remoteAddr[i]; result *= 16777619UL;}
+  }
+  return result;
+}
+
+/**
+ *  Refresh a matching entry if there is one, otherwise take the first free (or expired) slot. An entry may not be 
+ *  added under a uuid or parent uuid that another owner has registered.
+ */
+const SSDPProxyEntry* SSDPProxy::add(SSDPRecordKind kind, const char* uuid, const char* puuid, const char* type, const char* name,
+                                     const char* location, int numDevices, int numServices, unsigned long ttlSeconds, uint32_t owner) {
+  SSDPProxyEntry* result = NULL;
+  SSDPProxyEntry* slot   = NULL;
+  if( !owns(uuid,owner) || ((puuid != NULL) && !owns(puuid,owner)) ) {
+    _rejected++;
+    return NULL;
+  }
+  unsigned long now = millis();
+  for( int i=0; (i<_capacity) && (result == NULL); i++ ) {
+    SSDPProxyEntry* e = &_entries[i];
+    if( !isLive(e,now) ) {if( slot == NULL ) slot = e;}
+    else if( (e->kind == kind) && (strcmp(e->uuid,uuid) == 0) && (strcmp(e->type,type) == 0) ) result = e;
+  }
+  if( result == NULL ) result = slot;
+  if( result == NULL ) {
+    _dropped++;
+    return NULL;
+  }
+  if( ttlSeconds > PROXY_MAX_TTL ) ttlSeconds = PROXY_MAX_TTL;
+  result->kind        = kind;
+  result->numDevices  = numDevices;
+  result->numServices = numServices;
+  result->registered  = now;
+  result->ttl         = ttlSeconds*1000;
+  result->owner       = owner;
+  copy(result->uuid,SSDP_UUID_SIZE,uuid,strlen(uuid));
+  copy(result->puuid,SSDP_UUID_SIZE,puuid,((puuid != NULL)?(strlen(puuid)):(0)));
+  copy(result->type,SSDP_TYPE_SIZE,type,strlen(type));
+  copy(result->name,SSDP_NAME_SIZE,name,((name != NULL)?(strlen(name)):(0)));
+  copy(result->location,SSDP_LOC_BUFFER_SIZE,location,strlen(location));
+  return result;
+}
+
+/**
+ *  Return the value of :name:value: in desc, with its length in len, or NULL if the field is not present
+ */
+const char* SSDPProxy::field(const char* desc, const char* name, size_t* len) {
+  char key[16];
+  snprintf(key,sizeof(key),":%s:",name);
+  const char* result = strstr(desc,key);
+  *len = 0;
+  if( result != NULL ) {
+    result += strlen(key);
+    const char* end = strchr(result,':');
+    *len = ((end != NULL)?(end - result):(strlen(result)));
+  }
+  return result;
+}
+
+/**
+ *  A register message carries the headers of a search response, with the TTL in CACHE-CONTROL: max-age = seconds
+ */
+boolean SSDPProxy::add(UPnPBuffer* b, IPAddress remoteAddr) {
+  char usn[SSDP_HEADER_BUFFER_SIZE];
+  char loc[SSDP_HEADER_BUFFER_SIZE];
+  char desc[SSDP_HEADER_BUFFER_SIZE];
+  char cache[PROXY_CACHE_SIZE];
+  usn[0]   = '\0';
+  loc[0]   = '\0';
+  desc[0]  = '\0';
+  cache[0] = '\0';
+  if( !b->headerValue_P(PROXY_USN_HEADER,usn,SSDP_HEADER_BUFFER_SIZE) || !b->headerValue_P(DESC_LSC_HEADER,desc,SSDP_HEADER_BUFFER_SIZE) ||
+      !b->headerValue_P(PROXY_LOCATION_HEADER,loc,SSDP_HEADER_BUFFER_SIZE) || !b->headerValue_P(PROXY_CACHE_HEADER,cache,PROXY_CACHE_SIZE) ) 
+    return false;
+
+  const char* maxAge = strstr_P(cache,PROXY_MAX_AGE);
+  if( maxAge == NULL ) return false;
+  maxAge += strlen_P(PROXY_MAX_AGE);
+  while( (*maxAge == ' ') || (*maxAge == '=') ) maxAge++;
+  unsigned long ttl = strtoul(maxAge,NULL,10);
+
+/**
+ *  USN is uuid:device-UUID::urn:domain-name:device:deviceType:ver
+ */
+  const char* uuid = usn;
+  if( strncmp_P(uuid,PROXY_UUID_PREFIX,5) == 0 ) uuid += 5;
+  char* delim = strstr_P(uuid,PROXY_DELIM);
+  if( (delim == NULL) || (ttl == 0) ) return false;
+  *delim = '\0';
+  const char* type = delim + 2;
+
+  char   name[SSDP_NAME_SIZE];
+  char   puuid[SSDP_UUID_SIZE];
+  size_t nameLen, puuidLen, devLen, svcLen;
+  const char* n    = field(desc,"name",&nameLen);
+  const char* p    = field(desc,"puuid",&puuidLen);
+  const char* devs = field(desc,"devices",&devLen);
+  const char* svcs = field(desc,"services",&svcLen);
+  copy(name,SSDP_NAME_SIZE,n,nameLen);
+  copy(puuid,SSDP_UUID_SIZE,p,puuidLen);
+  SSDPRecordKind kind = ((p == NULL)?(SSDP_ROOT_RECORD):((svcs != NULL)?(SSDP_DEVICE_RECORD):(SSDP_SERVICE_RECORD)));
+  return add(kind,uuid,puuid,type,name,loc,((devs != NULL)?(atoi(devs)):(0)),((svcs != NULL)?(atoi(svcs)):(0)),ttl,ownerKey(b,remoteAddr)) != NULL;
+}
+
+const SSDPProxyEntry* SSDPProxy::entry(const char* uuid) const {
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) {
+    const SSDPProxyEntry* e = &_entries[i];
+    if( isLive(e,now) && (e->kind != SSDP_SERVICE_RECORD) && (strcmp(e->uuid,uuid) == 0) ) return e;
+  }
+  return NULL;
+}
+
+/**
+ *  The parent of a service is its device, which has the same uuid. The parent of an embedded device is its RootDevice.
+ */
+const SSDPProxyEntry* SSDPProxy::parent(const SSDPProxyEntry* e) const {
+  if( e->kind == SSDP_ROOT_RECORD ) return NULL;
+  return entry(e->puuid);
+}
+
+int SSDPProxy::depth(const SSDPProxyEntry* e) const {
+  int result = 0;
+  if( e->kind == SSDP_DEVICE_RECORD ) result = 1;
+  else if( e->kind == SSDP_SERVICE_RECORD ) {
+    const SSDPProxyEntry* p = parent(e);
+    result = (((p != NULL) && (p->kind == SSDP_DEVICE_RECORD))?(2):(1));
+  }
+  return result;
+}
+
+void SSDPProxy::forEach(SSDPProxyHandler handler) const {
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) if( isLive(&_entries[i],now) ) handler(&_entries[i]);
+}
+
+/**
+ *  Services of e are entries of kind service with puuid e->uuid; embedded devices of a RootDevice have puuid e->uuid
+ */
+void SSDPProxy::forEachChild(const SSDPProxyEntry* e, SSDPProxyHandler handler) const {
+  if( e->kind == SSDP_SERVICE_RECORD ) return;
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) {
+    const SSDPProxyEntry* c = &_entries[i];
+    if( isLive(c,now) && (c != e) && (strcmp(c->puuid,e->uuid) == 0) ) {
+      if( (c->kind == SSDP_SERVICE_RECORD) || (e->kind == SSDP_ROOT_RECORD) ) handler(c);
+    }
+  }
+}
+
+int SSDPProxy::remove(const char* uuid, uint32_t owner) {
+  if( !owns(uuid,owner) ) {
+    _rejected++;
+    return -1;
+  }
+  return removeAll(uuid);
+}
+
+/**
+ *  Embedded devices are removed first, with their services, then the device itself and its own services
+ */
+int SSDPProxy::removeAll(const char* uuid) {
+  int result = 0;
+  unsigned long now = millis();
+  for( int i=0; i<_capacity; i++ ) {
+    SSDPProxyEntry* e = &_entries[i];
+    if( isLive(e,now) && (e->kind == SSDP_DEVICE_RECORD) && (strcmp(e->puuid,uuid) == 0) && (strcmp(e->uuid,uuid) != 0) ) result += removeAll(e->uuid);
+  }
+  for( int i=0; i<_capacity; i++ ) {
+    SSDPProxyEntry* e = &_entries[i];
+    if( isLive(e,now) && ((strcmp(e->uuid,uuid) == 0) || (strcmp(e->puuid,uuid) == 0)) ) {
+      e->ttl = 0;
+      result++;
+    }
+  }
+  return result;
+}
+
+void SSDPProxy::node(const SSDPProxyEntry* e, SSDPNode& n) const {
+  n.kind        = e->kind;
+  n.uuid        = e->uuid;
+  n.puuid       = e->puuid;
+  n.type        = e->type;
+  n.name        = e->name;
+  n.numDevices  = e->numDevices;
+  n.numServices = e->numServices;
+  n.depth       = depth(e);
+  n.ref         = e;
+}
+
+void SSDPProxy::roots(SSDPNodeHandler handler) {
+  forEach([this,handler](const SSDPProxyEntry* e) {
+    SSDPNode n;
+    if( e->kind == SSDP_ROOT_RECORD ) {
+      this->node(e,n);
+      handler(n);
+    }
+  });
+}
+
+boolean SSDPProxy::find(const char* uuid, SSDPNode& n) {
+  const SSDPProxyEntry* e = entry(uuid);
+  if( e != NULL ) node(e,n);
+  return (e != NULL);
+}
+
+void SSDPProxy::children(const SSDPNode& n, SSDPNodeHandler handler) {
+  forEachChild((const SSDPProxyEntry*)n.ref,[this,handler](const SSDPProxyEntry* c) {
+    SSDPNode child;
+    this->node(c,child);
+    handler(child);
+  });
+}
+
+int SSDPProxy::match(const char* pattern, SSDPNodeHandler handler) {
+  int result = 0;
+  boolean glob = (strchr(pattern,'*') != NULL);
+  forEach([this,pattern,glob,handler,&result](const SSDPProxyEntry* e) {
+    if( (glob)?(SSDPTypeIndex::matches(pattern,e->type)):(strcmp(pattern,e->type) == 0) ) {
+      SSDPNode n;
+      this->node(e,n);
+      handler(n);
+      result++;
+    }
+  });
+  return result;
+}
+
+/**
+ *  Registered locations are those of the sleeping device, whatever interface the request arrived on
+ */
+void SSDPProxy::location(const SSDPNode& n, char buffer[], size_t size, IPAddress /* ifc */) {
+  copy(buffer,size,((const SSDPProxyEntry*)n.ref)->location,strlen(((const SSDPProxyEntry*)n.ref)->location));
+}
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPPROXY_H
+#define SSDPPROXY_H
+
+#include <Arduino.h>
+#include <new>
+#include "UPnPBuffer.h"
+#include "SSDPConfig.h"
+#include "SSDPResponseSet.h"
+#include "SSDPNodeProvider.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define PROXY_MAX_TTL  86400               // Longest registration accepted, in seconds
+
+/**
+ *  A device, embedded device or service registered with a proxy by a device that is asleep. Fields are those of a
+ *  search response; for a service, uuid is the uuid of its device (as in the service USN).
+ */
+typedef struct SSDPProxyEntry {
+  SSDPRecordKind  kind;
+  uint8_t         numDevices;
+  uint8_t         numServices;
+  unsigned long   registered;                        // millis() when registered or last refreshed
+  unsigned long   ttl;                               // Lifetime in milliseconds, 0 if the slot is free
+  uint32_t        owner;                             // Key of the registrant's token (see SSDPProxy::ownerKey)
+  char            uuid[SSDP_UUID_SIZE];
+  char            puuid[SSDP_UUID_SIZE];             // Empty for a RootDevice
+  char            type[SSDP_TYPE_SIZE];
+  char            name[SSDP_NAME_SIZE];
+  char            location[SSDP_LOC_BUFFER_SIZE];
+} SSDPProxyEntry;
+
+typedef std::function<void(const SSDPProxyEntry*)> SSDPProxyHandler;
+
+/**
+ *  Table of nodes registered by sleeping devices, answered by a mains powered SSDP responder on their behalf.
+ *  The table has a fixed number of entries allocated by begin(); entries expire after their TTL and are reused.
+ *  A registration for the same uuid, type and kind refreshes the existing entry. A uuid belongs to the device that
+ *  registered it until its entries expire. The device is known by the TOKEN.LEELANAUSOFTWARE.COM header of its register
+ *  messages, so it keeps its registrations when its address changes. Messages without a token are known by their source
+ *  address. Registrations for a uuid (or below it) and removals of it by any other device are rejected and counted in
+ *  rejected(). The responder reads the table through its SSDPNodeProvider interface, where a node's ref is its
+ *  SSDPProxyEntry.
+ */
+class SSDPProxy : public SSDPNodeProvider {
+  public:
+    SSDPProxy() {}
+    ~SSDPProxy()                                           {end();}
+
+    boolean     begin(int capacity);                       // Allocate capacity entries, returns false if out of memory
+    void        end();                                     // Release all entries
+    boolean     isEnabled()                    const       {return _entries != NULL;}
+    int         capacity()                     const       {return _capacity;}
+    int         size()                         const;      // Number of live entries
+    int         dropped()                      const       {return _dropped;}
+    int         rejected()                     const       {return _rejected;}
+    size_t      memoryUsed()                   const       {return _capacity*sizeof(SSDPProxyEntry);}
+
+    const SSDPProxyEntry* add(SSDPRecordKind kind, const char* uuid, const char* puuid, const char* type, const char* name,
+                              const char* location, int numDevices, int numServices, unsigned long ttlSeconds, uint32_t owner);
+    boolean     add(UPnPBuffer* b, IPAddress remoteAddr);  // Add the node in a register message, returns false if malformed, full or rejected
+    int         remove(const char* uuid, uint32_t owner);  // Remove the device with uuid and everything below it, returns count removed or -1 if rejected
+    boolean     owns(const char* uuid, uint32_t owner) const;   // True unless a live entry for uuid was registered by another owner
+    static uint32_t ownerKey(UPnPBuffer* b, IPAddress remoteAddr);  // Key of the token in b, or of remoteAddr if b has none
+
+    const SSDPProxyEntry* entry(const char* uuid)  const;  // Live RootDevice or device with uuid, NULL if none
+    const SSDPProxyEntry* parent(const SSDPProxyEntry* e) const;  // Live parent device of e, NULL if none
+    int         depth(const SSDPProxyEntry* e)     const;  // RootDevice 0, embedded device 1, services one deeper than their device
+    void        forEach(SSDPProxyHandler handler)  const;  // Call handler on each live entry
+    void        forEachChild(const SSDPProxyEntry* e, SSDPProxyHandler handler) const;  // Live services and devices of e
+
+    void        roots(SSDPNodeHandler handler);
+    boolean     find(const char* uuid, SSDPNode& node);
+    void        children(const SSDPNode& node, SSDPNodeHandler handler);
+    int         match(const char* pattern, SSDPNodeHandler handler);
+    void        location(const SSDPNode& node, char buffer[], size_t size, IPAddress ifc);
+
+  private:
+    SSDPProxyEntry* _entries  = NULL;
+    int             _capacity = 0;
+    int             _dropped  = 0;
+    int             _rejected = 0;
+
+    static boolean  isLive(const SSDPProxyEntry* e, unsigned long now)  {return (e->ttl > 0) && (now - e->registered < e->ttl);}
+    static void     copy(char dst[], size_t size, const char* src, size_t len);
+    void            node(const SSDPProxyEntry* e, SSDPNode& n) const;
+    static const char* field(const char* desc, const char* name, size_t* len);
+    int             removeAll(const char* uuid);
+
+    SSDPProxy(const SSDPProxy&)            = delete;
+    SSDPProxy& operator=(const SSDPProxy&) = delete;
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPResponseSet.h"
+#include "SSDPConfig.h"
+#include "SSDPHeaders.h"
+
+#if SSDP_CLIENT
+
+namespace lsc {
+
+#define RECORD_HEADER_SIZE SSDP_HEADER_BUFFER_SIZE
+
+const char REC_USN_HEADER[]      PROGMEM = "USN";
+const char REC_LOCATION_HEADER[] PROGMEM = "LOCATION";
+
+SSDPArena::SSDPArena(size_t capacity) {
+  _base = (uint8_t*)malloc(capacity);
+  _capacity = ((_base != NULL)?(capacity):(0));
+}
+
+SSDPArena::~SSDPArena() {
+  if( _base != NULL ) free(_base);
+}
+
+void* SSDPArena::allocate(size_t size, size_t align) {
+  void* result = NULL;
+  size_t start = (_used + align - 1) & ~(align - 1);
+  if( start + size <= _capacity ) {
+    result = _base + start;
+    _used = start + size;
+    if( _used > _highWater ) _highWater = _used;
+  }
+  return result;
+}
+
+const char* SSDPArena::copy(const char* str, size_t len) {
+  char* result = (char*)allocate(len+1,1);
+  if( result != NULL ) {
+    memcpy(result,str,len);
+    result[len] = '\0';
+  }
+  return result;
+}
+
+SSDPStringTable::SSDPStringTable(SSDPArena& arena, uint16_t maxStrings) : _arena(arena) {
+  _maxStrings = ((maxStrings < 1)?(1):((maxStrings > 0x7FFF)?(0x7FFF):(maxStrings)));
+  allocate();
+}
+
+/**
+ *  Hash slots are kept at least half empty so probe sequences stay short
+ */
+boolean SSDPStringTable::allocate() {
+  _slotCount = 2*_maxStrings;
+  _size      = 0;
+  _slots     = (uint16_t*)_arena.allocate(_slotCount*sizeof(uint16_t),sizeof(uint16_t));
+  _strings   = (const char**)_arena.allocate(_maxStrings*sizeof(const char*));
+  if( (_slots == NULL) || (_strings == NULL) ) {
+    _slots   = NULL;
+    _strings = NULL;
+    return false;
+  }
+  memset(_slots,0,_slotCount*sizeof(uint16_t));
+  _strings[0] = "";
+  _size = 1;
+  return true;
+}
+
+uint32_t SSDPStringTable::hash(const char* str, size_t len) {
+  uint32_t result = 2166136261u;               // FNV-1a
+  for( size_t i=0; i<len; i++ ) {
+    result ^= (uint8_t)str[i];
+    result *= 16777619u;
+  }
+  return result;
+}
+
+uint16_t SSDPStringTable::intern(const char* str, size_t len) {
+  if( len == 0 ) return SSDP_EMPTY_STRING;
+  if( _slots == NULL ) return SSDP_NO_STRING;
+  uint16_t slot = hash(str,len) % _slotCount;
+  while( _slots[slot] != 0 ) {
+    uint16_t id = _slots[slot] - 1;
+    if( (strncmp(_strings[id],str,len) == 0) && (_strings[id][len] == '\0') ) return id;
+    slot = (slot + 1) % _slotCount;
+  }
+  if( _size >= _maxStrings ) return SSDP_NO_STRING;
+  const char* copy = _arena.copy(str,len);
+  if( copy == NULL ) return SSDP_NO_STRING;
+  uint16_t id = _size++;
+  _strings[id] = copy;
+  _slots[slot] = id + 1;
+  return id;
+}
+
+/**
+ *  Strings are removed newest first, which leaves the hash slots exactly as they were before they were interned. Their 
+ *  copies stay in the arena; the caller rewinds it to where it was when the table had size strings.
+ */
+void SSDPStringTable::truncate(uint16_t size) {
+  if( _slots == NULL ) return;
+  while( _size > size ) {
+    uint16_t id   = _size - 1;
+    uint16_t slot = hash(_strings[id],strlen(_strings[id])) % _slotCount;
+    while( (_slots[slot] != 0) && (_slots[slot] != id + 1) ) slot = (slot + 1) % _slotCount;
+    _slots[slot] = 0;
+    _size--;
+  }
+}
+
+const char* SSDPStringTable::string(uint16_t id) const {
+  return (((_strings != NULL) && (id < _size))?(_strings[id]):(""));
+}
+
+SSDPResponseSet::SSDPResponseSet(size_t capacity, uint16_t maxStrings) : _arena(capacity), _strings(_arena,maxStrings) {}
+
+void SSDPResponseSet::clear() {
+  _arena.reset();
+  _strings.allocate();
+  _first   = NULL;
+  _last    = NULL;
+  _size    = 0;
+  _dropped = 0;
+}
+
+/**
+ *  Return the value of :name:value: in desc, with its length in len, or NULL if the field is not present
+ */
+const char* SSDPResponseSet::field(const char* desc, const char* name, size_t* len) {
+  char key[16];
+  snprintf(key,sizeof(key),":%s:",name);
+  const char* result = strstr(desc,key);
+  *len = 0;
+  if( result != NULL ) {
+    result += strlen(key);
+    const char* end = strchr(result,':');
+    *len = ((end != NULL)?(end - result):(strlen(result)));
+  }
+  return result;
+}
+
+SSDPRecord* SSDPResponseSet::add(UPnPBuffer* b) {
+  SSDPRecord* result = NULL;
+  char usn[RECORD_HEADER_SIZE];
+  char loc[RECORD_HEADER_SIZE];
+  char desc[RECORD_HEADER_SIZE];
+  usn[0]  = '\0';
+  loc[0]  = '\0';
+  desc[0] = '\0';
+  if( b->headerValue_P(DESC_LSC_HEADER,desc,RECORD_HEADER_SIZE) && b->headerValue_P(REC_USN_HEADER,usn,RECORD_HEADER_SIZE) ) {
+    b->headerValue_P(REC_LOCATION_HEADER,loc,RECORD_HEADER_SIZE);
+
+    const char* uuid;
+    const char* type;
+    size_t      uuidLen, typeLen;
+    UPnPBuffer::splitUSN(usn,strlen(usn),&uuid,&uuidLen,&type,&typeLen);
+
+    size_t nameLen, puuidLen, devLen, svcLen;
+    const char* name  = field(desc,"name",&nameLen);
+    const char* puuid = field(desc,"puuid",&puuidLen);
+    const char* devs  = field(desc,"devices",&devLen);
+    const char* svcs  = field(desc,"services",&svcLen);
+
+    result = add(((puuid == NULL)?(SSDP_ROOT_RECORD):((svcs != NULL)?(SSDP_DEVICE_RECORD):(SSDP_SERVICE_RECORD))),
+                 uuid,uuidLen,type,typeLen,puuid,puuidLen,name,nameLen,loc,
+                 ((devs != NULL)?(atoi(devs)):(0)),((svcs != NULL)?(atoi(svcs)):(0)));
+  }
+  return result;
+}
+
+SSDPRecord* SSDPResponseSet::add(SSDPRecordKind kind, const char* uuid, const char* type, const char* puuid, 
+                                 const char* name, const char* location, int numDevices, int numServices) {
+  return add(kind,uuid,strlen(uuid),type,strlen(type),puuid,((puuid!=NULL)?(strlen(puuid)):(0)),name,((name!=NULL)?(strlen(name)):(0)),
+             location,numDevices,numServices);
+}
+
+SSDPRecord* SSDPResponseSet::add(SSDPRecordKind kind, const char* uuid, size_t uuidLen, const char* type, size_t typeLen, const char* puuid, size_t puuidLen,
+                                 const char* name, size_t nameLen, const char* location, int numDevices, int numServices) {
+  SSDPRecord* result = NULL;
+  size_t   mark    = _arena.used();
+  uint16_t strings = _strings.size();
+  SSDPRecord* r = (SSDPRecord*)_arena.allocate(sizeof(SSDPRecord));
+  if( r != NULL ) {
+    r->kind        = kind;
+    r->uuid        = _strings.intern(uuid,uuidLen);
+    r->type        = _strings.intern(type,typeLen);
+    r->puuid       = ((puuid != NULL)?(_strings.intern(puuid,puuidLen)):(SSDP_EMPTY_STRING));
+    r->name        = ((name != NULL)?(_arena.copy(name,nameLen)):(_arena.copy("")));
+    r->location    = _arena.copy(location);
+    r->numDevices  = numDevices;
+    r->numServices = numServices;
+    r->next        = NULL;
+    if( (r->uuid != SSDP_NO_STRING) && (r->type != SSDP_NO_STRING) && (r->puuid != SSDP_NO_STRING) && 
+        (r->name != NULL) && (r->location != NULL) ) result = r;
+  }
+
+/**
+ *  If the record did not fit, forget the strings interned for it and roll the arena back, so a partial record does not 
+ *  consume space
+ */
+  if( result == NULL ) {
+    _dropped++;
+    _strings.truncate(strings);
+    _arena.rewind(mark);
+  }
+  else {
+    if( _last != NULL ) _last->next = result;
+    else _first = result;
+    _last = result;
+    _size++;
+  }
+  return result;
+}
+
+} // End of namespace lsc
+
+#endif
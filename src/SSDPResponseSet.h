@@ -0,0 +1,156 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPRESPONSESET_H
+#define SSDPRESPONSESET_H
+
+#include <Arduino.h>
+#include "UPnPBuffer.h"
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  Bump allocator over a single block allocated on construction. Allocation is a pointer increment and reset() releases
+ *  everything at once, so a search result set never fragments the heap no matter how many records it holds.
+ */
+class SSDPArena {
+  public:
+    SSDPArena(size_t capacity);
+    ~SSDPArena();
+
+    void*         allocate(size_t size, size_t align = sizeof(void*));    // Returns NULL if the arena is exhausted
+    const char*   copy(const char* str, size_t len);                      // Copy len chars of str plus null termination
+    const char*   copy(const char* str)                     {return copy(str,strlen(str));}
+    void          reset()                                   {_used = 0;}
+    void          rewind(size_t mark)                       {if( mark < _used ) _used = mark;}   // Release everything allocated after used() was mark
+    size_t        used()                     const          {return _used;}
+    size_t        capacity()                 const          {return _capacity;}
+    size_t        highWater()                const          {return _highWater;}
+
+  private:
+    uint8_t*      _base      = NULL;
+    size_t        _capacity  = 0;
+    size_t        _used      = 0;
+    size_t        _highWater = 0;
+
+    SSDPArena(const SSDPArena&)            = delete;
+    SSDPArena& operator=(const SSDPArena&) = delete;
+};
+
+typedef enum {
+  SSDP_ROOT_RECORD    = 0,
+  SSDP_DEVICE_RECORD  = 1,
+  SSDP_SERVICE_RECORD = 2
+} SSDPRecordKind;
+
+#define SSDP_NO_STRING   0xFFFF         // String id returned when a string table is full
+#define SSDP_EMPTY_STRING 0              // String id of the empty string
+
+/**
+ *  Table of interned strings held in an SSDPArena. Each distinct string is stored once and identified by a small integer
+ *  id, so equal strings have equal ids. Lookup is an open addressed hash on the string; the table has a fixed number of
+ *  ids set on construction and returns SSDP_NO_STRING when it is full. Id 0 is always the empty string.
+ */
+class SSDPStringTable {
+  public:
+    SSDPStringTable(SSDPArena& arena, uint16_t maxStrings);
+
+    uint16_t      intern(const char* str, size_t len);                   // Return the id of str, adding it if necessary
+    uint16_t      intern(const char* str)                   {return intern(str,strlen(str));}
+    const char*   string(uint16_t id)        const;                      // Return the string for id, or "" if id is unknown
+    uint16_t      size()                     const          {return _size;}
+    boolean       allocate();                                            // (Re)allocate the table from the arena, after arena reset
+    void          truncate(uint16_t size);                               // Forget the strings interned after the table had size strings
+
+  private:
+    SSDPArena&    _arena;
+    uint16_t      _maxStrings;
+    uint16_t      _slotCount = 0;
+    uint16_t*     _slots     = NULL;                                     // Hash slots holding id+1, 0 if empty
+    const char**  _strings   = NULL;                                     // Strings by id
+    uint16_t      _size      = 0;
+
+    static uint32_t hash(const char* str, size_t len);
+};
+
+/**
+ *  A parsed search response. Strings are held in the owning SSDPResponseSet's arena and are valid until the set
+ *  is cleared or destroyed. For a service, uuid is the uuid of the parent device (as in the service USN).
+ *  Type and uuid strings repeat across a sweep, so they are interned: records hold string ids that compare equal exactly
+ *  when the strings are equal, and SSDPResponseSet::string(id) returns the text.
+ */
+typedef struct SSDPRecord {
+  SSDPRecordKind  kind;
+  uint16_t        uuid;                  // Id of the device uuid from USN
+  uint16_t        type;                  // Id of the device or service type from USN
+  uint16_t        puuid;                 // Id of the parent uuid from DESC, SSDP_EMPTY_STRING for a RootDevice
+  const char*     name;                  // Display name from DESC
+  const char*     location;              // LOCATION header
+  uint8_t         numDevices;            // Embedded devices of a RootDevice
+  uint8_t         numServices;           // Services of a device
+  SSDPRecord*     next;                  // Next record in arrival order
+} SSDPRecord;
+
+/**
+ *  Result set for SSDP::searchRequest. Each LSC search response is parsed once into an SSDPRecord, and the record and 
+ *  its strings are placed contiguously in an arena of fixed capacity. Responses that do not fit are counted in dropped().
+ *  clear() releases the whole result set in constant time.
+ */
+class SSDPResponseSet {
+  public:
+    SSDPResponseSet(size_t capacity = SSDP_RESULT_CAPACITY, uint16_t maxStrings = SSDP_RESULT_STRINGS);
+
+    int                 size()       const        {return _size;}
+    int                 dropped()    const        {return _dropped;}
+    SSDPRecord*         first()      const        {return _first;}
+    const SSDPArena&    arena()      const        {return _arena;}
+    const char*         string(uint16_t id) const {return _strings.string(id);}
+    const SSDPStringTable& strings() const        {return _strings;}
+    boolean             compact()    const        {return _compact;}
+    void                compact(boolean c)        {_compact = c;}       // Request compact binary responses (see SSDPCompact.h)
+    void                clear();
+
+    SSDPRecord*         add(UPnPBuffer* b);       // Parse a search response into a new record, returns NULL if it could not be added
+    SSDPRecord*         add(SSDPRecordKind kind, const char* uuid, const char* type, const char* puuid, const char* name,
+                            const char* location, int numDevices, int numServices);    // Add an already decoded response
+    
+  private:
+    SSDPArena           _arena;
+    SSDPStringTable     _strings;
+    SSDPRecord*         _first   = NULL;
+    SSDPRecord*         _last    = NULL;
+    int                 _size    = 0;
+    int                 _dropped = 0;
+    boolean             _compact = false;
+
+    const char*         field(const char* desc, const char* name, size_t* len);
+    SSDPRecord*         add(SSDPRecordKind kind, const char* uuid, size_t uuidLen, const char* type, size_t typeLen, const char* puuid, size_t puuidLen,
+                            const char* name, size_t nameLen, const char* location, int numDevices, int numServices);
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#include "SSDPStatsService.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+INITIALIZE_STATIC_TYPE(SSDPStatsService);
+INITIALIZE_UPnP_TYPE(SSDPStatsService,urn:LEELANAUSOFTWARE-com:service:ssdpStats:1);
+
+const char* const LATENCY_NAMES[SSDP_REQ_CLASSES] = {"rootdevice","rootdeviceAll","uuid","urn"};
+
+SSDPStatsService::SSDPStatsService(SSDP* ssdp) : UPnPService() {
+  _ssdp = ssdp;
+  setDisplayName("SSDP Statistics");
+  setTarget("ssdpStats");
+}
+
+void SSDPStatsService::setup(WebContext* svr) {
+  UPnPService::setup(svr);
+  char pathBuffer[SSDP_PATH_SIZE];
+  handlerPath(pathBuffer,SSDP_PATH_SIZE);
+  svr->on(pathBuffer,[this](WebContext* svr){this->handleRequest(svr);});
+}
+
+void SSDPStatsService::handleRequest(WebContext* svr) {
+  char buffer[STATS_BUFFER_SIZE];
+  render(buffer,STATS_BUFFER_SIZE);
+  svr->send(200,"application/json",buffer);
+}
+
+size_t SSDPStatsService::histogram(char buffer[], size_t size, const char* name, const SSDPHistogram& h) {
+  int len = snprintf_P(buffer,size,PSTR("\"%s\":{\"n\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}"),name,(unsigned long)h.count(),
+                       (unsigned long)h.percentile(50),(unsigned long)h.percentile(99),(unsigned long)h.max());
+  return ((len < 0)?(0):(((size_t)len < size)?(len):(size - 1)));
+}
+
+/**
+ *  Each section is appended in turn; a buffer too small for all of them yields truncated (invalid) JSON rather than
+ *  overflowing, so STATS_BUFFER_SIZE covers every section.
+ */
+size_t SSDPStatsService::render(char buffer[], size_t size) {
+  size_t len = 0;
+  auto append = [&](int n) {if( n > 0 ) len = ((len + n < size)?(len + n):(size - 1));};
+  buffer[0] = '\0';
+
+  const SSDPReceiveStats& r = _ssdp->receiveStats();
+  append(snprintf_P(buffer+len,size-len,PSTR("{\"uptime\":%lu,\"responder\":{\"received\":%lu,\"truncated\":%lu,\"rejected\":%lu,\"posting\":%s},"),
+                    millis(),(unsigned long)r.received,(unsigned long)r.truncated,(unsigned long)r.rejected,
+                    ((_ssdp->isPosting())?("true"):("false"))));
+
+  append(snprintf_P(buffer+len,size-len,PSTR("\"latency\":{")));
+  for( int i=0; i<SSDP_REQ_CLASSES; i++ ) {
+    append(histogram(buffer+len,size-len,LATENCY_NAMES[i],_ssdp->responseLatency((SSDPRequestClass)i)));
+    append(snprintf_P(buffer+len,size-len,PSTR(",")));
+  }
+  append(histogram(buffer+len,size-len,"queueWait",_ssdp->queueWait()));
+  append(snprintf_P(buffer+len,size-len,PSTR(",")));
+  append(histogram(buffer+len,size-len,"sendTime",_ssdp->sendTime()));
+  append(snprintf_P(buffer+len,size-len,PSTR("}")));
+
+  const SSDPProxy& proxy = _ssdp->proxy();
+  if( proxy.isEnabled() ) append(snprintf_P(buffer+len,size-len,PSTR(",\"proxy\":{\"size\":%d,\"capacity\":%d,\"dropped\":%d,\"rejected\":%d}"),
+                                            proxy.size(),proxy.capacity(),proxy.dropped(),proxy.rejected()));
+  const SSDPChangeLog& changes = _ssdp->changeLog();
+  if( changes.capacity() > 0 ) append(snprintf_P(buffer+len,size-len,PSTR(",\"changeLog\":{\"generation\":%lu,\"size\":%d}"),
+                                                 (unsigned long)changes.generation(),changes.size()));
+
+  SSDPMemoryReport m = _ssdp->memoryReport();
+  append(snprintf_P(buffer+len,size-len,PSTR(",\"memory\":{\"budget\":%lu,\"used\":%lu,\"typeIndex\":%s,\"changeLog\":%d,\"proxy\":%d}"),
+                    (unsigned long)m.budget,(unsigned long)m.used,((m.typeIndex)?("true"):("false")),m.changeLog,m.proxy));
+
+#if SSDP_CLIENT
+  const SSDPReceiveStats& s = SSDP::searchStats();
+  append(snprintf_P(buffer+len,size-len,PSTR(",\"client\":{\"received\":%lu,\"truncated\":%lu,\"lost\":%lu,\"recovered\":%lu}"),
+                    (unsigned long)s.received,(unsigned long)s.truncated,(unsigned long)s.lost,(unsigned long)s.recovered));
+#endif
+
+  uint32_t freeHeap = ESP.getFreeHeap();
+#ifdef ESP8266
+  uint32_t maxBlock = ESP.getMaxFreeBlockSize();
+  if( freeHeap < _minHeap ) _minHeap = freeHeap;
+  uint32_t minHeap  = _minHeap;
+#elif defined(ESP32)
+  uint32_t maxBlock = ESP.getMaxAllocHeap();
+  uint32_t minHeap  = ESP.getMinFreeHeap();
+#endif
+  append(snprintf_P(buffer+len,size-len,PSTR(",\"heap\":{\"free\":%lu,\"maxBlock\":%lu,\"min\":%lu}}"),
+                    (unsigned long)freeHeap,(unsigned long)maxBlock,(unsigned long)minHeap));
+  return len;
+}
+
+} // End of namespace lsc
+
+#endif
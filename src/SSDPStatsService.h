@@ -0,0 +1,73 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#ifndef SSDPSTATSSERVICE_H
+#define SSDPSTATSSERVICE_H
+
+#include <Arduino.h>
+#include <UPnPDevice.h>
+#include "ssdp.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+/**
+ *  Diagnostics service serving SSDP runtime metrics as compact JSON at its handler path, so a fleet scraper can read
+ *  them over HTTP. Add it to a RootDevice (or embedded UPnPDevice) like any other UPnPService; it answers urn: searches
+ *  for urn:LEELANAUSOFTWARE-com:service:ssdpStats:1 with its LOCATION. Served metrics are:
+ *     responder  - Requests received, truncated and rejected (SSDP::receiveStats), whether a paced post is in progress
+ *     latency    - Count, p50, p99 and max in microseconds of responseLatency by request class, queueWait and sendTime
+ *     proxy      - Live entries, capacity and registrations dropped, if a proxy table is enabled
+ *     changeLog  - Generation and changes held, if a change log is enabled
+ *     memory     - SSDP::memoryReport(), the memory budget and the structures held within it
+ *     client     - SSDP::searchStats() of the most recent search, in builds with the client
+ *     heap       - Free heap, largest free block, and the least free heap seen (by the core on ESP32, at each request
+ *                  to this service on ESP8266)
+ *  For example:
+ *     SSDPStatsService stats(&ssdp);
+ *     root.addService(&stats);
+ *     root.setup(&ctx);
+ */
+class SSDPStatsService : public UPnPService {
+  public:
+    SSDPStatsService(SSDP* ssdp);
+
+    void          setup(WebContext* svr);
+    void          handleRequest(WebContext* svr);
+    size_t        render(char buffer[], size_t size);   // Render the metrics JSON into buffer, returns its length
+
+  private:
+    SSDP*         _ssdp;
+    uint32_t      _minHeap = 0xFFFFFFFF;
+
+    static size_t histogram(char buffer[], size_t size, const char* name, const SSDPHistogram& h);
+
+  DEFINE_RTTI;
+  DERIVED_TYPE_CHECK(UPnPService);
+};
+
+} // End of namespace lsc
+
+#endif
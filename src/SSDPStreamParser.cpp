@@ -0,0 +1,152 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPStreamParser.h"
+
+namespace lsc {
+
+SSDPStreamParser::SSDPStreamParser(char buffer[], size_t size, const PGM_P accept[], int numAccept, const PGM_P keep[], int numKeep) :
+  _buffer(buffer), _size(size), _accept(accept), _numAccept(numAccept), _keep(keep), _numKeep(numKeep) {
+  _buffer[0] = '\0';
+}
+
+SSDPParseState SSDPStreamParser::parse(const char* data, size_t len) {
+  for( size_t i=0; (i<len) && (_state == SSDP_PARSE_MORE); i++ ) consume(data[i]);
+  return _state;
+}
+
+/**
+ *  A datagram may end without the blank line, or inside a header
+ */
+SSDPParseState SSDPStreamParser::finish() {
+  if( _state != SSDP_PARSE_MORE ) return _state;
+  if( (_step == START_LINE) && (acceptable() != 1) ) _state = SSDP_PARSE_REJECTED;
+  else {
+    if( (_step == START_LINE) || (_step == VALUE) ) {
+      if( !append("\r\n",2) ) {_len = _lineStart; _truncated = true;}
+    }
+    end();
+  }
+  return _state;
+}
+
+void SSDPStreamParser::end() {
+  memcpy(_buffer+_len,"\r\n",3);                          // Room is always left for the blank line
+  _len  += 2;
+  _state = SSDP_PARSE_DONE;
+}
+
+/**
+ *  Append to buffer, leaving room for the blank line and null termination
+ */
+boolean SSDPStreamParser::append(const char* s, size_t len) {
+  if( _len + len + 3 > _size ) return false;
+  memcpy(_buffer+_len,s,len);
+  _len += len;
+  _buffer[_len] = '\0';
+  return true;
+}
+
+int SSDPStreamParser::acceptable() const {
+  int result = 0;
+  for( int i=0; i<_numAccept; i++ ) {
+    size_t n = strlen_P(_accept[i]);
+    if( _len >= n ) {
+      if( strncmp_P(_buffer,_accept[i],n) == 0 ) return 1;
+    }
+    else if( strncmp_P(_buffer,_accept[i],_len) == 0 ) result = -1;
+  }
+  return result;
+}
+
+boolean SSDPStreamParser::isKept() const {
+  for( int i=0; i<_numKeep; i++ ) if( strcmp_P(_name,_keep[i]) == 0 ) return true;
+  return false;
+}
+
+void SSDPStreamParser::consume(char c) {
+  if( c == '\r' ) return;
+  switch( _step ) {
+    case START_LINE:
+      if( c == '\n' ) {
+        if( (_accepted || (acceptable() == 1)) && append("\r\n",2) ) {
+          _step    = NAME;
+          _nameLen = 0;
+        }
+        else _state = SSDP_PARSE_REJECTED;                // No room to terminate the start line
+      }
+      else if( !append(&c,1) ) _state = SSDP_PARSE_REJECTED;
+      else if( !_accepted ) {
+        int a = acceptable();
+        if( a == 0 ) _state = SSDP_PARSE_REJECTED;
+        _accepted = (a == 1);
+      }
+      break;
+    case NAME:
+      if( c == '\n' ) {
+        if( _nameLen == 0 ) end();                        // Blank line ends the headers
+        _nameLen = 0;
+      }
+      else if( c == ':' ) {
+        while( (_nameLen > 0) && (_name[_nameLen-1] == ' ') ) _nameLen--;
+        _name[_nameLen] = '\0';
+        _lineStart = _len;
+        boolean kept = isKept();
+        if( kept && append(_name,_nameLen) && append(":",1) ) _step = VALUE;
+        else {
+          if( kept ) _truncated = true;
+          _len  = _lineStart;
+          _buffer[_len] = '\0';
+          _step = SKIP;
+        }
+      }
+      else if( (c == ' ') && (_nameLen == 0) ) {}         // Leading blanks
+      else if( _nameLen < PARSE_NAME_SIZE - 1 ) _name[_nameLen++] = c;
+      else _step = SKIP;                                  // Longer than any header of interest
+      break;
+    case VALUE:
+      if( c == '\n' ) {
+        if( !append("\r\n",2) ) {
+          _len = _lineStart;
+          _buffer[_len] = '\0';
+          _truncated = true;
+        }
+        _step    = NAME;
+        _nameLen = 0;
+      }
+      else if( !append(&c,1) ) {
+        _len = _lineStart;
+        _buffer[_len] = '\0';
+        _truncated = true;
+        _step = SKIP;
+      }
+      break;
+    case SKIP:
+      if( c == '\n' ) {
+        _step    = NAME;
+        _nameLen = 0;
+      }
+      break;
+  }
+}
+
+} // End of namespace lsc
@@ -0,0 +1,88 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPSTREAMPARSER_H
+#define SSDPSTREAMPARSER_H
+
+#include <Arduino.h>
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define READ_CHUNK_SIZE    64              // Bytes read from a channel at a time
+#define PARSE_NAME_SIZE    32              // Longest header name of interest, including null termination
+
+typedef enum {
+  SSDP_PARSE_MORE     = 0,                 // Headers not complete, feed the next chunk
+  SSDP_PARSE_DONE     = 1,                 // Blank line ending the headers reached
+  SSDP_PARSE_REJECTED = 2                  // Start line is not one of the accepted kinds
+} SSDPParseState;
+
+/**
+ *  Resumable parser that consumes a datagram in chunks, as read from a WiFiUDP, and keeps only the start line and
+ *  the headers of interest, so the whole datagram is never held in memory. Kept lines are copied into buffer in
+ *  their original order and buffer reads as a packet for UPnPBuffer. Headers that do not fit are dropped whole
+ *  and noted by truncated(). The packet is rejected as soon as its start line can not begin with any accepted prefix,
+ *  so unwanted packets are not read past their first chunk.
+ *  Prefixes and header names are in flash; header names match exactly, as in UPnPBuffer::headerValue.
+ */
+class SSDPStreamParser {
+  public:
+    SSDPStreamParser(char buffer[], size_t size, const PGM_P accept[], int numAccept, const PGM_P keep[], int numKeep);
+
+    SSDPParseState  parse(const char* data, size_t len);  // Consume a chunk
+    SSDPParseState  finish();                             // End of datagram, close the packet if it had no blank line
+    SSDPParseState  state()                 const        {return _state;}
+    boolean         truncated()             const        {return _truncated;}
+    const char*     packet()                const        {return _buffer;}
+
+  private:
+    typedef enum {START_LINE, NAME, VALUE, SKIP} Step;
+
+    char*           _buffer;
+    size_t          _size;
+    size_t          _len       = 0;
+    size_t          _lineStart = 0;                       // Start of the line being kept, to drop it if it does not fit
+    const PGM_P*    _accept;
+    int             _numAccept;
+    const PGM_P*    _keep;
+    int             _numKeep;
+    char            _name[PARSE_NAME_SIZE];
+    size_t          _nameLen   = 0;
+    Step            _step      = START_LINE;
+    SSDPParseState  _state     = SSDP_PARSE_MORE;
+    boolean         _accepted  = false;
+    boolean         _truncated = false;
+
+    void            consume(char c);
+    boolean         append(const char* s, size_t len);
+    int             acceptable()            const;        // 1 accepted, 0 rejected, -1 not yet known
+    boolean         isKept()                const;
+    void            end();
+};
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,207 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#include "SSDPTimerWheel.h"
+
+namespace lsc {
+
+#define TIMER_NONE     0xFFFF                  // No timer, ends slot and free lists
+#define TIMER_FIRING   0xFFFE                  // Slot of a timer unlinked by advance() whose handler has not been called
+#define TIMER_MASK     (SSDP_TIMER_SLOTS - 1)
+
+SSDPTimerWheel::SSDPTimerWheel() {
+  for( int i=0; i<SSDP_TIMERS; i++ ) {
+    _timers[i].next       = ((i+1 < SSDP_TIMERS)?(i+1):(TIMER_NONE));
+    _timers[i].prev       = TIMER_NONE;
+    _timers[i].generation = 1;
+    _timers[i].slot       = TIMER_NONE;
+  }
+  for( int i=0; i<SSDP_TIMER_SLOTS; i++ ) _slots[i] = TIMER_NONE;
+  memset(_occupied,0,sizeof(_occupied));
+  _free     = 0;
+  _tick     = millis() >> TIMER_TICK_SHIFT;
+  _earliest = 0;
+}
+
+/**
+ *  Schedule handler to be called by advance() delay milliseconds from now. Returns the timer id, or SSDP_NO_TIMER
+ *  if all SSDP_TIMERS timers are pending.
+ */
+SSDPTimer SSDPTimerWheel::schedule(unsigned long delay, SSDPTimerHandler handler) {
+  if( (_free == TIMER_NONE) || !handler ) return SSDP_NO_TIMER;
+  uint16_t i = _free;
+  Timer& t   = _timers[i];
+  _free      = t.next;
+  t.due      = millis() + delay;
+  t.handler  = handler;
+  link(i);
+  if( _earliestValid && ((_size == 0) || ((long)(t.due - _earliest) < 0)) ) _earliest = t.due;
+  _size++;
+  return ((SSDPTimer)t.generation << 16) | i;
+}
+
+boolean SSDPTimerWheel::cancel(SSDPTimer timer) {
+  uint16_t i = index(timer);
+  if( i == TIMER_NONE ) return false;
+  Timer& t = _timers[i];
+  if( t.slot == TIMER_FIRING ) {
+    if( !t.handler ) return false;
+    t.handler = nullptr;                           // Unlinked by advance(), which skips it
+  }
+  else {
+    unlink(i);
+    release(i);
+  }
+  if( --_size == 0 ) _earliestValid = true;
+  else if( t.due == _earliest ) _earliestValid = false;
+  return true;
+}
+
+boolean SSDPTimerWheel::pending(SSDPTimer timer) const {
+  uint16_t i = index(timer);
+  return (i != TIMER_NONE) && ((_timers[i].slot != TIMER_FIRING) || _timers[i].handler);
+}
+
+/**
+ *  Visit the slots of the ticks from the last tick advanced through to now, at most one turn of the wheel, and 
+ *  unlink the timers due by now onto a fired list. The last tick is visited again since timers due later in that
+ *  tick may remain. Handlers are called after the slots are visited, each timer released before its handler runs.
+ */
+int SSDPTimerWheel::advance() {
+  unsigned long now   = millis();
+  unsigned long tick  = now >> TIMER_TICK_SHIFT;
+  unsigned long ticks = tick - _tick + 1;
+  if( ticks > SSDP_TIMER_SLOTS ) ticks = SSDP_TIMER_SLOTS;
+  uint16_t first = TIMER_NONE;
+  uint16_t last  = TIMER_NONE;
+  if( _size > 0 ) {
+    for( unsigned long k=0; k<ticks; k++ ) {
+      int slot = (_tick + k) & TIMER_MASK;
+      if( (_occupied[slot >> 5] & (1UL << (slot & 31))) == 0 ) continue;
+      uint16_t i = _slots[slot];
+      while( i != TIMER_NONE ) {
+        uint16_t next = _timers[i].next;
+        if( (long)(_timers[i].due - now) <= 0 ) {
+          unlink(i);
+          _timers[i].slot = TIMER_FIRING;
+          _timers[i].next = TIMER_NONE;
+          if( last == TIMER_NONE ) first = i;
+          else _timers[last].next = i;
+          last = i;
+        }
+        i = next;
+      }
+    }
+  }
+  _tick = tick;
+
+  int result = 0;
+  while( first != TIMER_NONE ) {
+    uint16_t i = first;
+    Timer&   t = _timers[i];
+    first      = t.next;
+    SSDPTimerHandler handler = t.handler;
+    boolean  cancelled = !handler;
+    if( !cancelled ) {
+      if( --_size == 0 ) _earliestValid = true;
+      else if( t.due == _earliest ) _earliestValid = false;
+    }
+    release(i);
+    if( !cancelled ) {
+      handler();
+      result++;
+    }
+  }
+  return result;
+}
+
+/**
+ *  The earliest due time is kept as timers are scheduled, and recomputed from the occupied slots only after the
+ *  earliest timer fires or is cancelled.
+ */
+unsigned long SSDPTimerWheel::nextDeadline() {
+  if( _size == 0 ) return SSDP_NO_DEADLINE;
+  unsigned long now = millis();
+  if( !_earliestValid ) {
+    long best = 0;
+    boolean found = false;
+    for( int w=0; w<SSDP_TIMER_SLOTS/32; w++ ) {
+      uint32_t bits = _occupied[w];
+      for( int b=0; bits != 0; b++, bits >>= 1 ) {
+        if( (bits & 1) == 0 ) continue;
+        for( uint16_t i=_slots[(w << 5) + b]; i != TIMER_NONE; i=_timers[i].next ) {
+          long wait = (long)(_timers[i].due - now);
+          if( !found || (wait < best) ) {
+            best      = wait;
+            _earliest = _timers[i].due;
+            found     = true;
+          }
+        }
+      }
+    }
+    if( !found ) _earliest = now;                // Only timers unlinked by advance() remain, due now
+    _earliestValid = true;
+  }
+  long wait = (long)(_earliest - now);
+  return ((wait > 0)?(wait):(0));
+}
+
+void SSDPTimerWheel::link(uint16_t i) {
+  Timer& t = _timers[i];
+  t.slot   = (t.due >> TIMER_TICK_SHIFT) & TIMER_MASK;
+  t.prev   = TIMER_NONE;
+  t.next   = _slots[t.slot];
+  if( t.next != TIMER_NONE ) _timers[t.next].prev = i;
+  _slots[t.slot] = i;
+  _occupied[t.slot >> 5] |= (1UL << (t.slot & 31));
+}
+
+void SSDPTimerWheel::unlink(uint16_t i) {
+  Timer& t = _timers[i];
+  if( t.prev != TIMER_NONE ) _timers[t.prev].next = t.next;
+  else _slots[t.slot] = t.next;
+  if( t.next != TIMER_NONE ) _timers[t.next].prev = t.prev;
+  if( _slots[t.slot] == TIMER_NONE ) _occupied[t.slot >> 5] &= ~(1UL << (t.slot & 31));
+}
+
+/**
+ *  Return timer i to the free list. Its generation is advanced (skipping 0) so ids issued for it no longer match.
+ */
+void SSDPTimerWheel::release(uint16_t i) {
+  Timer& t  = _timers[i];
+  t.handler = nullptr;
+  t.slot    = TIMER_NONE;
+  if( ++t.generation == 0 ) t.generation = 1;
+  t.next    = _free;
+  _free     = i;
+}
+
+uint16_t SSDPTimerWheel::index(SSDPTimer timer) const {
+  uint16_t i = timer & 0xFFFF;
+  if( (timer == SSDP_NO_TIMER) || (i >= SSDP_TIMERS) ) return TIMER_NONE;
+  const Timer& t = _timers[i];
+  if( (t.generation != (timer >> 16)) || (t.slot == TIMER_NONE) ) return TIMER_NONE;
+  return i;
+}
+
+} // End of namespace lsc
@@ -0,0 +1,90 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+
+#ifndef SSDPTIMERWHEEL_H
+#define SSDPTIMERWHEEL_H
+
+#include <Arduino.h>
+#include "SSDPConfig.h"
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+#define TIMER_TICK_SHIFT   3                   // Ticks are 2^3 = 8 milliseconds, a power of 2 so slots survive millis() wrap
+#define SSDP_NO_TIMER      0                   // Timer id that is never issued
+#define SSDP_NO_DEADLINE   0xFFFFFFFFUL        // nextDeadline() when no timed work is pending
+
+typedef uint32_t                   SSDPTimer;  // Timer id, generation in the high 16 bits and pool index in the low 16
+typedef std::function<void(void)>  SSDPTimerHandler;
+
+/**
+ *  Hashed timing wheel. A timer is hashed by its due tick into one of SSDP_TIMER_SLOTS slots, each a doubly linked 
+ *  list of timers drawn from a fixed pool of SSDP_TIMERS, so schedule and cancel are constant time and nothing is 
+ *  allocated. advance() visits only the slots of the ticks elapsed since the last call (every slot at most once),
+ *  unlinks the timers due in them and then calls their handlers in tick order, so a handler may schedule or cancel
+ *  timers. Timers due more than one turn of the wheel ahead stay in their slot until their turn comes.
+ *  A timer id carries a generation, so cancelling a timer that already fired (or whose pool entry was reused) does 
+ *  nothing.
+ */
+class SSDPTimerWheel {
+  public:
+    SSDPTimerWheel();
+
+    SSDPTimer     schedule(unsigned long delay, SSDPTimerHandler handler);  // Call handler in delay ms, SSDP_NO_TIMER if the pool is full
+    boolean       cancel(SSDPTimer timer);                                  // Returns false if timer is not pending
+    boolean       pending(SSDPTimer timer)     const;
+    int           advance();                                                // Call handlers of timers due by now, returns the number fired
+    unsigned long nextDeadline();                                           // Milliseconds until the next timer is due, SSDP_NO_DEADLINE if none
+    int           size()                       const   {return _size;}
+    int           capacity()                   const   {return SSDP_TIMERS;}
+
+  private:
+    typedef struct {
+      unsigned long    due;                      // millis() when due
+      SSDPTimerHandler handler;
+      uint16_t         next;                     // Next in slot or free list
+      uint16_t         prev;                     // Previous in slot, TIMER_NONE if first
+      uint16_t         generation;
+      uint16_t         slot;                     // Slot holding the timer, TIMER_NONE if free
+    } Timer;
+
+    Timer         _timers[SSDP_TIMERS];
+    uint16_t      _slots[SSDP_TIMER_SLOTS];      // First timer of each slot
+    uint32_t      _occupied[SSDP_TIMER_SLOTS/32];// Bit per non-empty slot
+    uint16_t      _free;                         // First free timer
+    unsigned long _tick;                         // Last tick advanced through
+    unsigned long _earliest;                     // Earliest due time, valid if _earliestValid
+    boolean       _earliestValid = true;
+    int           _size          = 0;
+
+    void          link(uint16_t i);
+    void          unlink(uint16_t i);
+    void          release(uint16_t i);
+    uint16_t      index(SSDPTimer timer)       const;   // Pool index of a pending timer, TIMER_NONE if not pending
+};
+
+} // End of namespace lsc
+
+#endif
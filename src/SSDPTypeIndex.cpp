@@ -0,0 +1,215 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#include "SSDPTypeIndex.h"
+#include "SSDPConfig.h"
+
+#if SSDP_RESPONDER
+
+namespace lsc {
+
+/**
+ *  Count type characters and objects for root and everything below it. The character count is an upper bound on the
+ *  number of trie nodes.
+ */
+void SSDPTypeIndex::count(RootDevice* root, size_t& chars, size_t& objects) {
+  chars   = strlen(root->getType());
+  objects = 1;
+  UPnPService** services = root->services();
+  for( int i=0; i<root->numServices(); i++ ) {chars += strlen(services[i]->getType()); objects++;}
+  UPnPDevice** devices = root->devices();
+  for( int i=0; i<root->numDevices(); i++ ) {
+    chars += strlen(devices[i]->getType()); 
+    objects++;
+    UPnPService** dServices = devices[i]->services();
+    for( int j=0; j<devices[i]->numServices(); j++ ) {chars += strlen(dServices[j]->getType()); objects++;}
+  }
+}
+
+size_t SSDPTypeIndex::memoryRequired(RootDevice* root) {
+  size_t chars, objects;
+  count(root,chars,objects);
+  return (chars+1)*(sizeof(Node)+sizeof(uint8_t)) + objects*sizeof(Entry);
+}
+
+size_t SSDPTypeIndex::memoryUsed() const {
+  return _nodeCap*(sizeof(Node)+sizeof(uint8_t)) + _entryCap*sizeof(Entry);
+}
+
+void SSDPTypeIndex::clear() {
+  if( _nodes != NULL )   delete[] _nodes;
+  if( _entries != NULL ) delete[] _entries;
+  if( _visited != NULL ) delete[] _visited;
+  _nodes      = NULL;
+  _entries    = NULL;
+  _visited    = NULL;
+  _nodeCount  = 0;
+  _nodeCap    = 0;
+  _entryCount = 0;
+  _entryCap   = 0;
+}
+
+boolean SSDPTypeIndex::build(RootDevice* root) {
+  clear();
+  if( root == NULL ) return false;
+  size_t chars, objects;
+  count(root,chars,objects);
+  if( chars + 1 > 0xFFFF ) return false;
+  _nodeCap  = chars + 1;
+  _entryCap = objects;
+  _nodes    = new (std::nothrow) Node[_nodeCap];
+  _entries  = new (std::nothrow) Entry[_entryCap];
+  _visited  = new (std::nothrow) uint8_t[_nodeCap];
+  if( (_nodes == NULL) || (_entries == NULL) || (_visited == NULL) ) {clear(); return false;}
+
+  _nodes[0].c       = '\0';
+  _nodes[0].child   = 0;
+  _nodes[0].sibling = 0;
+  _nodes[0].entry   = -1;
+  _nodeCount = 1;
+
+  boolean result = insert(root->getType(),root,NULL);
+  UPnPService** services = root->services();
+  for( int i=0; i<root->numServices(); i++ ) result = result && insert(services[i]->getType(),NULL,services[i]);
+  UPnPDevice** devices = root->devices();
+  for( int i=0; (i<root->numDevices()) && result; i++ ) {
+    result = insert(devices[i]->getType(),devices[i],NULL);
+    UPnPService** dServices = devices[i]->services();
+    for( int j=0; j<devices[i]->numServices(); j++ ) result = result && insert(dServices[j]->getType(),NULL,dServices[j]);
+  }
+  if( !result ) clear();
+  return result;
+}
+
+boolean SSDPTypeIndex::insert(const char* type, UPnPDevice* device, UPnPService* service) {
+  uint16_t node = 0;
+  for( const char* c = type; *c != '\0'; c++ ) {
+    uint16_t child = _nodes[node].child;
+    while( (child != 0) && (_nodes[child].c != *c) ) child = _nodes[child].sibling;
+    if( child == 0 ) {
+      if( _nodeCount >= _nodeCap ) return false;
+      child = _nodeCount++;
+      _nodes[child].c       = *c;
+      _nodes[child].child   = 0;
+      _nodes[child].entry   = -1;
+      _nodes[child].sibling = _nodes[node].child;
+      _nodes[node].child    = child;
+    }
+    node = child;
+  }
+  if( _entryCount >= _entryCap ) return false;
+  int16_t e = _entryCount++;
+  _entries[e].device  = device;
+  _entries[e].service = service;
+  _entries[e].stamp   = 0;
+  _entries[e].next    = _nodes[node].entry;
+  _nodes[node].entry  = e;
+  return true;
+}
+
+int SSDPTypeIndex::match(const char* pattern, SSDPTypeHandler handler) {
+  int count = 0;
+  if( (_nodes != NULL) && (pattern != NULL) && isValidPattern(pattern) ) {
+    if( ++_stamp == 0 ) {
+      for( int i=0; i<_entryCount; i++ ) _entries[i].stamp = 0;
+      _stamp = 1;
+    }
+    memset(_visited,0,_nodeCount);
+    walk(0,pattern,0,handler,count);
+  }
+  return count;
+}
+
+void SSDPTypeIndex::report(uint16_t node, SSDPTypeHandler& handler, int& count) {
+  for( int16_t e = _nodes[node].entry; e >= 0; e = _entries[e].next ) {
+    if( _entries[e].stamp != _stamp ) {
+      _entries[e].stamp = _stamp;
+      count++;
+      handler(_entries[e].device,_entries[e].service);
+    }
+  }
+}
+
+/**
+ *  Match the remainder of pattern against the subtrie at node, where star is the number of '*' runs already passed. 
+ *  A '*' run either matches nothing (advance the pattern) or consumes one more character (descend into every child 
+ *  with the same pattern). The rest of the walk depends only on the node and the run, so each pair is walked once.
+ */
+void SSDPTypeIndex::walk(uint16_t node, const char* pattern, int star, SSDPTypeHandler& handler, int& count) {
+  if( *pattern == '\0' ) {
+    report(node,handler,count);
+  }
+  else if( *pattern == '*' ) {
+    if( _visited[node] & (1 << star) ) return;
+    _visited[node] |= (1 << star);
+    const char* next = pattern;
+    while( *next == '*' ) next++;
+    walk(node,next,star+1,handler,count);
+    for( uint16_t child = _nodes[node].child; child != 0; child = _nodes[child].sibling ) walk(child,pattern,star,handler,count);
+  }
+  else {
+    for( uint16_t child = _nodes[node].child; child != 0; child = _nodes[child].sibling ) {
+      if( _nodes[child].c == *pattern ) {
+        walk(child,pattern+1,star,handler,count);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ *  Glob match keeping only the most recent '*' as a backtrack point: on a mismatch the '*' takes one more character
+ *  and matching resumes after it. An earlier '*' never needs to be retried, so this is O(pattern length * type length).
+ */
+boolean SSDPTypeIndex::matches(const char* pattern, const char* type) {
+  const char* star  = NULL;                        // Last '*' seen in pattern
+  const char* mark  = NULL;                        // Position in type that '*' has matched up to
+  while( *type != '\0' ) {
+    if( *pattern == '*' ) {
+      star = pattern++;
+      mark = type;
+    }
+    else if( *pattern == *type ) {
+      pattern++;
+      type++;
+    }
+    else if( star != NULL ) {
+      pattern = star + 1;
+      type    = ++mark;
+    }
+    else return false;
+  }
+  while( *pattern == '*' ) pattern++;
+  return (*pattern == '\0');
+}
+
+boolean SSDPTypeIndex::isValidPattern(const char* pattern) {
+  int runs = 0;
+  for( const char* p = pattern; *p != '\0'; p++ ) {
+    if( (*p == '*') && (*(p+1) != '*') ) runs++;
+  }
+  return (runs <= SSDP_PATTERN_STARS);
+}
+
+} // End of namespace lsc
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SSDPTYPEINDEX_H
+#define SSDPTYPEINDEX_H
+
+#include <Arduino.h>
+#include <new>
+#include <UPnPDevice.h>
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+typedef std::function<void(UPnPDevice*,UPnPService*)> SSDPTypeHandler;   // Called with exactly one of device or service set
+
+#define SSDP_PATTERN_STARS   8               // Most '*' runs a pattern may contain
+
+/**
+ *  Trie over the device and service types hosted by a RootDevice. Types share long prefixes (urn:domain-name:device:), 
+ *  so a trie stores each prefix once and a search walks only the part of the trie the pattern can reach. Patterns are
+ *  type strings that may contain '*', which matches any sequence of characters, for example:
+ *     urn:LEELANAUSOFTWARE-com:service:*              Every service in the domain
+ *     urn:LEELANAUSOFTWARE-com:device:SoftwareClock:* Every version of a device type
+ *  A pattern without '*' matches a type exactly. Each matching device or service is reported once. Consecutive '*' are
+ *  treated as one, and a pattern with more than SSDP_PATTERN_STARS runs of '*' matches nothing.
+ */
+class SSDPTypeIndex {
+  public:
+    SSDPTypeIndex() {}
+    ~SSDPTypeIndex()                                                       {clear();}
+
+    boolean          build(RootDevice* root);                              // Index the types of root and all its devices and services
+    void             clear();                                              // Release the index
+    boolean          isBuilt()                        const                {return _nodes != NULL;}
+    int              match(const char* pattern, SSDPTypeHandler handler);  // Call handler on each match, returns the number of matches
+    size_t           memoryUsed()                     const;
+
+    static boolean   matches(const char* pattern, const char* type);       // Return true if type matches pattern
+    static boolean   isValidPattern(const char* pattern);                  // Return false if pattern has too many '*' runs
+    static size_t    memoryRequired(RootDevice* root);                     // Bytes needed to index root
+
+  private:
+    typedef struct {
+      char           c;
+      uint16_t       child;                  // First child, 0 if none (node 0 is the root and never a child)
+      uint16_t       sibling;                // Next sibling, 0 if none
+      int16_t        entry;                  // First entry whose type ends at this node, -1 if none
+    } Node;
+
+    typedef struct {
+      UPnPDevice*    device;
+      UPnPService*   service;
+      int16_t        next;                   // Next entry with the same type, -1 if none
+      uint16_t       stamp;                  // Match generation that last reported this entry
+    } Entry;
+
+    Node*            _nodes      = NULL;
+    Entry*           _entries    = NULL;
+    uint8_t*         _visited    = NULL;     // Per node, bit k set if the walk reached the node at the k-th '*' run
+    uint16_t         _nodeCount  = 0;
+    uint16_t         _nodeCap    = 0;
+    uint16_t         _entryCount = 0;
+    uint16_t         _entryCap   = 0;
+    uint16_t         _stamp      = 0;
+
+    boolean          insert(const char* type, UPnPDevice* device, UPnPService* service);
+    void             walk(uint16_t node, const char* pattern, int star, SSDPTypeHandler& handler, int& count);
+    void             report(uint16_t node, SSDPTypeHandler& handler, int& count);
+    static void      count(RootDevice* root, size_t& chars, size_t& objects);
+
+    SSDPTypeIndex(const SSDPTypeIndex&)            = delete;
+    SSDPTypeIndex& operator=(const SSDPTypeIndex&) = delete;
+};
+
+} // End of namespace lsc
+
+#endif
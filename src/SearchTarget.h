@@ -0,0 +1,116 @@
+/**
+ * 
+ *  ssdp Library
+ *  Copyright (C) 2023  Daniel L Toth
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published 
+ *  by the Free Software Foundation, either version 3 of the License, or any 
+ *  later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *  
+ *  The author can be contacted at dan@leelanausoftware.com  
+ *
+ */
+
+#ifndef SEARCHTARGET_H
+#define SEARCHTARGET_H
+
+#include <Arduino.h>
+#include "SSDPHeaders.h"
+
+/**
+ *  Compile time Search Targets. A SearchTarget pairs an ST with the complete M-SEARCH datagram for it, both as flash
+ *  resident string literals built by the preprocessor. The ST is checked with a static_assert, so a malformed ST fails 
+ *  the build rather than returning SSDP_ERR_ST, and sending the request needs no formatting. Declare at file scope:
+ *  
+ *     SSDP_SEARCH_TARGET(ROOT_SEARCH,  "upnp:rootdevice", "");
+ *     SSDP_SEARCH_TARGET(ALL_SEARCH,   "upnp:rootdevice", "ssdp:all");
+ *     SSDP_SEARCH_TARGET(CLOCK_SEARCH, SSDP_DEVICE_URN("LEELANAUSOFTWARE-com","SoftwareClock","1"), "ssdp:all");
+ *     SSDP_SEARCH_TARGET(DEVICE_SEARCH,"uuid:b2234c12-417f-4e3c-b5d6-4d418143e85d", "ssdp:all");
+ *
+ *  and search with SSDP::searchRequest(CLOCK_SEARCH,handler,WiFi.localIP(),5000). The third argument is the value of the
+ *  ST.LEELANAUSOFTWARE.COM header, either "" or "ssdp:all".
+ */
+
+#define SSDP_SEARCH_PACKET(st,opt)         "M-SEARCH * HTTP/1.1\r\n"                          \
+                                           "HOST: 239.255.255.250:1900\r\n"                   \
+                                           "MAN: ssdp:discover\r\n"                           \
+                                           "ST: " st "\r\n"                                   \
+                                           SSDP_LSC_ST ": " opt "\r\n"                       \
+                                           "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n\r\n"
+
+#define SSDP_URN(domain,kind,type,ver)     "urn:" domain ":" kind ":" type ":" ver
+#define SSDP_DEVICE_URN(domain,type,ver)   SSDP_URN(domain,"device",type,ver)
+#define SSDP_SERVICE_URN(domain,type,ver)  SSDP_URN(domain,"service",type,ver)
+
+#define SSDP_SEARCH_TARGET(name,st,opt)                                                                          \
+  static_assert(lsc::SearchTarget::isValid(st),        "Malformed SSDP Search Target: " st);                     \
+  static_assert(lsc::SearchTarget::isValidOption(opt), "ST.LEELANAUSOFTWARE.COM must be \"\" or \"ssdp:all\"");  \
+  const char name##_ST[]     PROGMEM = st;                                                                       \
+  const char name##_PACKET[] PROGMEM = SSDP_SEARCH_PACKET(st,opt);                                               \
+  const lsc::SearchTarget name(name##_ST,name##_PACKET)
+
+/** Leelanau Software Company namespace 
+*  
+*/
+namespace lsc {
+
+class SearchTarget {
+  public:
+    constexpr SearchTarget(PGM_P st, PGM_P packet) : _st(st), _packet(packet) {}
+
+    PGM_P          st()        const     {return _st;}                  // Search Target, in flash
+    PGM_P          packet()    const     {return _packet;}              // Complete M-SEARCH datagram, in flash
+
+/**
+ *  ST validation, usable in constant expressions. A valid ST is one of:
+ *     upnp:rootdevice
+ *     uuid:xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx                  where x is a hex digit
+ *     urn:domain-name:device:deviceType:ver                       where ver is decimal digits
+ *     urn:domain-name:service:serviceType:ver
+ *     urn:type-pattern                                            where the pattern contains '*' and no blanks
+ */
+    static constexpr boolean isValid(const char* st) {
+      return equals(st,"upnp:rootdevice") || 
+             (startsWith(st,"uuid:") && isUUID(st+5,0)) || 
+             (startsWith(st,"urn:") && (isURN(st+4) || isPattern(st+4,false)));
+    }
+    static constexpr boolean isValidOption(const char* opt) {return equals(opt,"") || equals(opt,"ssdp:all");}
+
+  private:
+    PGM_P          _st;
+    PGM_P          _packet;
+
+    static constexpr boolean equals(const char* a, const char* b)      {return (*a == *b) && ((*a == '\0') || equals(a+1,b+1));}
+    static constexpr boolean startsWith(const char* s, const char* p)  {return (*p == '\0') || ((*s == *p) && startsWith(s+1,p+1));}
+    static constexpr boolean isHex(char c)                             {return ((c>='0')&&(c<='9')) || ((c>='a')&&(c<='f')) || ((c>='A')&&(c<='F'));}
+    static constexpr boolean isDigit(char c)                           {return (c>='0')&&(c<='9');}
+    static constexpr boolean isToken(char c)                           {return (c > ' ') && (c < 127) && (c != ':');}
+    static constexpr const char* skipToken(const char* s)              {return (isToken(*s)?(skipToken(s+1)):(s));}
+
+    static constexpr boolean isUUID(const char* s, int i) {
+      return (i == 36)?(s[i] == '\0'):
+             ((s[i] != '\0') && (((i==8)||(i==13)||(i==18)||(i==23))?(s[i] == '-'):(isHex(s[i]))) && isUUID(s,i+1));
+    }
+    static constexpr boolean isVersion(const char* s)                  {return isDigit(*s) && ((s[1] == '\0') || isVersion(s+1));}
+    static constexpr boolean isTypeVersion(const char* s)              {return (skipToken(s) != s) && (*skipToken(s) == ':') && isVersion(skipToken(s)+1);}
+    static constexpr boolean isKindTypeVersion(const char* s) {
+      return (startsWith(s,"device:")?(isTypeVersion(s+7)):(startsWith(s,"service:") && isTypeVersion(s+8)));
+    }
+    static constexpr boolean isPattern(const char* s, boolean star) {
+      return (*s == '\0')?(star):((*s > ' ') && (*s < 127) && isPattern(s+1,star || (*s == '*')));
+    }
+    static constexpr boolean isURN(const char* s)                      {return (skipToken(s) != s) && (*skipToken(s) == ':') && isKindTypeVersion(skipToken(s)+1);}
+};
+
+} // End of namespace lsc
+
+#endif
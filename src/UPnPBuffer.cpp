@@ -21,13 +21,17 @@
  */
 
 #include "UPnPBuffer.h"
+#include "SSDPConfig.h"
+#include "SSDPHeaders.h"
 
 namespace lsc {
 
 const char M_SEARCH_HEADER[]     PROGMEM = "M-SEARCH";
 const char RESPONSE_HEADER[]     PROGMEM = "HTTP/1.1";
-const char DESC_LSC_HEADER[]     PROGMEM = "DESC.LEELANAUSOFTWARE.COM";
+const char NOTIFY_HEADER[]       PROGMEM = "NOTIFY";
 const char END_OF_LINE[]         PROGMEM = "\r\n";
+const char USN_UUID_PREFIX[]     PROGMEM = "uuid:";
+const char USN_TYPE_PREFIX[]     PROGMEM = "urn:";
 
 
 UPnPBuffer::UPnPBuffer(const char* buff) {
@@ -150,9 +154,9 @@ boolean  UPnPBuffer::hasNextLine(const char* lineStart) {
 int   UPnPBuffer::maxLineLength() {return _maxLen;}
 
 boolean UPnPBuffer::displayName(char buffer[], size_t len) {
-  char headerBuffer[200];
+  char headerBuffer[SSDP_HEADER_BUFFER_SIZE];
   buffer[0] = '\0';
-  boolean result = headerValue_P(DESC_LSC_HEADER,headerBuffer,200);
+  boolean result = headerValue_P(DESC_LSC_HEADER,headerBuffer,SSDP_HEADER_BUFFER_SIZE);
   if( result ) {
      char* start = strstr(headerBuffer,":name:");
      if( start != NULL ) {
@@ -178,7 +182,88 @@ boolean UPnPBuffer::headerValue_P(PGM_P header, char buffer[], size_t len) {
   return headerValue(cheader,buffer,len);
 }
 
+boolean UPnPBuffer::generation(uint32_t& generation) {
+  char headerBuffer[SSDP_HEADER_BUFFER_SIZE];
+  boolean result = headerValue_P(SYNC_LSC_HEADER,headerBuffer,SSDP_HEADER_BUFFER_SIZE);
+  if( result ) {
+    const char* start = strstr_P(headerBuffer,SYNC_GENERATION);
+    result = (start != NULL);
+    if( result ) generation = strtoul(start+strlen_P(SYNC_GENERATION),NULL,10);
+  }
+  return result;
+}
+
+/**
+ *  Return true if the SYNC header is :generation:G:kind: for the given kind (SYNC_DELTA, SYNC_FULL or SYNC_REMOVED)
+ */
+boolean UPnPBuffer::isSync(PGM_P kind) {
+  char headerBuffer[SSDP_HEADER_BUFFER_SIZE];
+  if( !headerValue_P(SYNC_LSC_HEADER,headerBuffer,SSDP_HEADER_BUFFER_SIZE) ) return false;
+  const char* p = strstr_P(headerBuffer,SYNC_GENERATION);
+  if( p == NULL ) return false;
+  p += strlen_P(SYNC_GENERATION);
+  while( isdigit(*p) ) p++;
+  if( *p++ != ':' ) return false;
+  size_t len = strlen_P(kind);
+  return (strncmp_P(p,kind,len) == 0) && (p[len] == ':');
+}
+
+boolean UPnPBuffer::isRemoved() {
+  return isSync(SYNC_REMOVED);
+}
+
+boolean UPnPBuffer::isFullSync() {
+  return isSync(SYNC_FULL);
+}
+
+boolean UPnPBuffer::burst(uint32_t& id, int& index, int& total) {
+  char headerBuffer[SSDP_HEADER_BUFFER_SIZE];
+  boolean result = headerValue_P(BURST_LSC_HEADER,headerBuffer,SSDP_HEADER_BUFFER_SIZE);
+  if( result ) {
+    const char* i = strstr_P(headerBuffer,BURST_ID);
+    const char* x = strstr_P(headerBuffer,BURST_INDEX);
+    const char* t = strstr_P(headerBuffer,BURST_TOTAL);
+    result = (i != NULL) && (x != NULL) && (t != NULL);
+    if( result ) {
+      id    = strtoul(i+strlen_P(BURST_ID),NULL,10);
+      index = atoi(x+strlen_P(BURST_INDEX));
+      total = atoi(t+strlen_P(BURST_TOTAL));
+    }
+  }
+  return result;
+}
+
+boolean UPnPBuffer::splitUSN(const char* usn, size_t len, const char** uuid, size_t* uuidLen, const char** type, size_t* typeLen) {
+  const char* end = usn + len;
+  if( (len >= 5) && (strncmp_P(usn,USN_UUID_PREFIX,5) == 0) ) usn += 5;
+  const char* delim = usn;
+  while( (delim + 1 < end) && !((delim[0] == ':') && (delim[1] == ':')) ) delim++;
+  if( delim + 1 >= end ) {
+    *uuid    = usn;
+    *uuidLen = end - usn;
+    *type    = end;
+    *typeLen = 0;
+    return false;
+  }
+  const char* first  = usn;
+  const char* second = delim + 2;
+  if( (delim - first >= 4) && (strncmp_P(first,USN_TYPE_PREFIX,4) == 0) ) {
+    *type    = first;
+    *typeLen = delim - first;
+    *uuid    = second;
+    *uuidLen = end - second;
+  }
+  else {
+    *uuid    = first;
+    *uuidLen = delim - first;
+    *type    = second;
+    *typeLen = end - second;
+  }
+  return true;
+}
+
 boolean UPnPBuffer::isSearchRequest()  {return (strncmp_P(_buffer,M_SEARCH_HEADER,8) == 0);}
 boolean UPnPBuffer::isSearchResponse() {return (strncmp_P(_buffer,RESPONSE_HEADER,8) == 0);}
+boolean UPnPBuffer::isNotify()         {return (strncmp_P(_buffer,NOTIFY_HEADER,6) == 0);}
 
 }
@@ -43,6 +43,20 @@ class UPnPBuffer {
     
     boolean isSearchRequest();                      // Return true if this message is a Search Request
     boolean isSearchResponse();                     // Return true if this message is a Search Response
+    boolean isNotify();                             // Return true if this message is a NOTIFY
+
+//  Delta sync responses carry a SYNC.LEELANAUSOFTWARE.COM header of :generation:G:delta:, :generation:G:full: or :generation:G:removed:
+    boolean generation(uint32_t& generation);       // Return true if SYNC header is present and fill generation with its :generation: value
+    boolean isRemoved();                            // Return true if this response reports a removed device or service
+    boolean isFullSync();                           // Return true if this response ends a sync that sent the full tree
+
+//  Responses to ssdp:all carry a BURST.LEELANAUSOFTWARE.COM header of :id:burst-id:index:i:total:n: (see SSDPBurst.h)
+    boolean burst(uint32_t& id, int& index, int& total);  // Return true if BURST header is present and fill in its values
+
+//  Split a USN value of len characters (it need not be null terminated) into uuid and type, returns false if it has no "::".
+//  Device USNs are uuid:device-UUID::type, while service USNs in search responses are uuid:serviceType::device-UUID, so
+//  whichever part starts with urn: is the type.
+    static boolean splitUSN(const char* usn, size_t len, const char** uuid, size_t* uuidLen, const char** type, size_t* typeLen);
 
 /** Line processing
  *  
@@ -56,6 +70,7 @@ class UPnPBuffer {
     int           _maxLen = 0;
 
     int           maxLen();
+    boolean       isSync(PGM_P kind);             // SYNC header is :generation:G:kind:
 
 };
 
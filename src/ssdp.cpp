@@ -156,59 +156,93 @@ namespace lsc {
 const IPAddress SSDP_MULTICAST(239,255,255,250);
 const long DELAY = 500;
 
-// buffer for sending and receiving UDP data
-#define TXN_BUFFER_SIZE    1536
-#define ST_HEADER_SIZE     100
-#define ST_LSC_HEADER_SIZE 20
-#define SSDP_BUFFER_SIZE   1000
+const long REGISTER_DELAY = 10;
+
+/** Request lines answered by the responder (NOTIFY only with a proxy table) and the headers it reads 
+ *  
+ */
+#if SSDP_RESPONDER
+const char  M_SEARCH_LINE[]       PROGMEM = "M-SEARCH";
+const char  NOTIFY_LINE[]         PROGMEM = "NOTIFY";
+const char  CACHE_HEADER[]        PROGMEM = "CACHE-CONTROL";
+const char  LOCATION_HEADER[]     PROGMEM = "LOCATION";
+#endif
 
 /** Response Templates
  *  
  */
+#if SSDP_RESPONDER
 const char  SERVICE_RESPONSE[]    PROGMEM = "HTTP/1.1 200 OK \r\n"
                                          "CACHE-CONTROL: max-age = 1800 \r\n"
                                          "LOCATION: %s\r\n"                                                          // Service Location
                                          "ST: %s\r\n"                                                                // Search Target
-                                         "USN: uuid:%s::%s\r\n"                                                      // Parent Device uuid and Service type
-                                         "DESC.LEELANAUSOFTWARE.COM: :name:%s:puuid:%s:\r\n\r\n\r\n";              // name and parent Device uuid
+                                         "USN: uuid:%s::%s\r\n"                                                      // Service type and parent Device uuid
+                                         SSDP_LSC_DESC ": :name:%s:puuid:%s:\r\n\r\n\r\n";                           // name and parent Device uuid
 
 const char  DEVICE_RESPONSE[]     PROGMEM = "HTTP/1.1 200 OK \r\n"
                                          "CACHE-CONTROL: max-age = 1800 \r\n"
                                          "LOCATION: %s\r\n"                                                          // Device Location
                                          "ST: %s\r\n"                                                                // Search Target
                                          "USN: uuid:%s::%s\r\n"                                                      // uuid and device type
-                                         "DESC.LEELANAUSOFTWARE.COM: :name:%s:services:%d:puuid:%s:\r\n\r\n\r\n";  // name, number of services, and parent uuid   
+                                         SSDP_LSC_DESC ": :name:%s:services:%d:puuid:%s:\r\n\r\n\r\n";               // name, number of services, and parent uuid   
 
 const char  ROOT_RESPONSE[]       PROGMEM = "HTTP/1.1 200 OK \r\n"
                                          "CACHE-CONTROL: max-age = 1800 \r\n"
                                          "LOCATION: %s\r\n"                                                           // Root Location
                                          "ST: %s\r\n"                                                                 // Search Target
                                          "USN: uuid:%s::%s\r\n"                                                       // uuid and device type
-                                         "DESC.LEELANAUSOFTWARE.COM: :name:%s:devices:%d:services:%d:\r\n\r\n\r\n"; // Number of Devices and Number of Services 
+                                         SSDP_LSC_DESC ": :name:%s:devices:%d:services:%d:\r\n\r\n\r\n";              // Number of Devices and Number of Services 
 
-const char SSDP_RootSearch[]      PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
-                                        "HOST: 239.255.255.250:1900\r\n"
-                                        "MAN: ssdp:discover\r\n"
-                                        "ST: upnp:rootdevice\r\n"
-                                        "ST.LEELANAUSOFTWARE.COM: \r\n"
-                                        "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n\r\n";
-const char SSDP_RootAllSearch[]   PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
-                                        "HOST: 239.255.255.250:1900\r\n"
-                                        "MAN: ssdp:discover\r\n"
-                                        "ST: upnp:rootdevice\r\n"
-                                        "ST.LEELANAUSOFTWARE.COM: ssdp:all\r\n"
-                                        "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n\r\n";
+/** Proxy register message, sent by a sleeping device to a proxy for each of its devices and services. Headers are
+ *  those of a search response, with the registration lifetime in CACHE-CONTROL.
+ */
+const char  REGISTER_MESSAGE[]    PROGMEM = "NOTIFY * HTTP/1.1\r\n"
+                                         "HOST: %d.%d.%d.%d:1900\r\n"
+                                         "CACHE-CONTROL: max-age = %d\r\n"                                            // Registration lifetime in seconds
+                                         "LOCATION: %s\r\n"                                                           // Device or Service Location
+                                         "NT: %s\r\n"                                                                 // Device or Service type
+                                         "NTS: %s\r\n"                                                                // lsc:register or lsc:unregister
+                                         "USN: uuid:%s::%s\r\n"                                                       // uuid and type
+                                         SSDP_LSC_DESC ": %s\r\n"                                                     // As for a search response
+                                         SSDP_LSC_TOKEN ": %s\r\n\r\n";                                               // Registrant
+const char  ROOT_DESC[]           PROGMEM = ":name:%s:devices:%d:services:%d:";
+const char  DEVICE_DESC[]         PROGMEM = ":name:%s:services:%d:puuid:%s:";
+const char  SERVICE_DESC[]        PROGMEM = ":name:%s:puuid:%s:";
+const char  NTS_HEADER[]          PROGMEM = "NTS";
+const char  NTS_REGISTER[]        PROGMEM = "lsc:register";
+const char  NTS_UNREGISTER[]      PROGMEM = "lsc:unregister";
+
+/** Delta sync response, reporting a removed device or service, or ending a sync with the responder's generation and 
+ *  whether the changes (delta) or the whole tree (full) were sent
+ */
+const char  SYNC_RESPONSE[]       PROGMEM = "HTTP/1.1 200 OK \r\n"
+                                         "CACHE-CONTROL: max-age = 1800 \r\n"
+                                         "ST: %s\r\n"                                                                 // Search Target
+                                         "USN: uuid:%s::%s\r\n"                                                       // As for a search response
+                                         SSDP_LSC_SYNC ": " SSDP_SYNC_GENERATION "%lu:%s:\r\n\r\n\r\n";               // delta, full or removed
+#endif
+
+#if SSDP_CLIENT
+const char SSDP_RootSearch[]      PROGMEM = SSDP_SEARCH_PACKET("upnp:rootdevice","");
+const char SSDP_RootAllSearch[]   PROGMEM = SSDP_SEARCH_PACKET("upnp:rootdevice","ssdp:all");
 const char SSDP_Search[]          PROGMEM = "M-SEARCH * HTTP/1.1\r\n"
                                         "HOST: 239.255.255.250:1900\r\n"
                                         "MAN: ssdp:discover\r\n"
                                         "ST: %s\r\n"
-                                        "ST.LEELANAUSOFTWARE.COM: ssdp:all\r\n"
+                                        SSDP_LSC_ST ": ssdp:all\r\n"
                                         "USER-AGENT: ESP8266 UPnP/1.1 LSC-SSDP/1.0\r\n\r\n";
+#endif
 
 /** Header field constants
  *  
  */
-const char ST_LSC_HEADER[]       PROGMEM = "ST.LEELANAUSOFTWARE.COM";
+const char FILTER_HEADER_LINE[]  PROGMEM = SSDP_LSC_FILTER ": %s\r\n\r\n";
+const char ENC_HEADER_LINE[]     PROGMEM = SSDP_LSC_ENC ": %s\r\n\r\n";
+const char ENC_COMPACT[]         PROGMEM = "lsc-bin/1";
+const char SINCE_HEADER_LINE[]   PROGMEM = SSDP_LSC_SINCE ": %s\r\n\r\n";
+const char BURST_HEADER_LINE[]   PROGMEM = SSDP_LSC_BURST ": %s\r\n\r\n";
+const char BURST_RECORD[]        PROGMEM = SSDP_LSC_BURST ": " SSDP_BURST_ID "%lu" SSDP_BURST_INDEX "%d" SSDP_BURST_TOTAL "%d:\r\n\r\n";
+const char HEADER_END[]          PROGMEM = "\r\n\r\n";
 const char ST_HEADER[]           PROGMEM = "ST";
 const char USN_HEADER[]          PROGMEM = "USN";
 const char ST_UPNP_ROOTDEVICE[]  PROGMEM = "upnp:rootdevice";
@@ -218,11 +252,25 @@ const char SSDP_ALL[]            PROGMEM = "ssdp:all";
 const char DELIM[]               PROGMEM = "::";
 
 
+#if SSDP_RESPONDER
+const PGM_P REQUEST_LINES[]   = {M_SEARCH_LINE, NOTIFY_LINE};
+const PGM_P REQUEST_HEADERS[] = {ST_HEADER, ST_LSC_HEADER, FILTER_LSC_HEADER, ENC_LSC_HEADER, SINCE_LSC_HEADER, BURST_LSC_HEADER,
+                                 NTS_HEADER, USN_HEADER, LOCATION_HEADER, CACHE_HEADER, DESC_LSC_HEADER, TOKEN_LSC_HEADER};
+#endif
+
 /**
  *  The following functions are needed to mitigate the differences between ESP8266 UDP and ESP32 UDP.
  *  Other wiFi implementations may need to address other functions.
  */
 
+#ifdef ESP32
+#if defined(ESP_ARDUINO_VERSION_MAJOR) && (ESP_ARDUINO_VERSION_MAJOR >= 2)
+#define SSDP_GOT_IP_EVENT ARDUINO_EVENT_STA_GOT_IP
+#else
+#define SSDP_GOT_IP_EVENT SYSTEM_EVENT_STA_GOT_IP
+#endif
+#endif
+
 void beginMulticast(WiFiUDP& channel) {
 #ifdef ESP32
   channel.beginMulticast(SSDP_MULTICAST,UDP_PORT);
@@ -249,49 +297,353 @@ void getUUID(char uuid[], int size, const char* st) {
 }
 
 LoggingLevel SSDP::_logging = NONE;
+#if SSDP_CLIENT
+SSDPReceiveStats SSDP::_searchStats = {0,0,0,0,0};
+#endif
 
 SSDP::SSDP() {}
 
 int SSDP::getMulticastPort() {return UDP_PORT;}
+#if SSDP_RESPONDER
 int SSDP::getUDPPort() {return getLocalPort(_udp);}
 
-void SSDP::begin(RootDevice* root) {
-  _root = root;
+SSDP::~SSDP() {
+  endPost(NULL);
+#ifdef ESP32
+  if( _gotIP != 0 ) WiFi.removeEvent(_gotIP);
+#endif
+}
+
+/**
+ *  Multicast membership and bound channels do not survive a WiFi reconnect, so begin() subscribes to the station 
+ *  getting an IP address and doSSDP() rearms the channels. The device tree and its indices are kept. WiFi events may
+ *  arrive on another task (ESP32), so the event only sets a flag.
+ */
+void SSDP::begin(RootDevice* root, size_t budget) {
+  _rootProvider.setRoot(root);
+  begin(&_rootProvider,budget);
+}
+
+/**
+ *  Answer searches from provider rather than a RootDevice object tree
+ */
+void SSDP::begin(SSDPNodeProvider* provider, size_t budget) {
+  _provider = provider;
+  _budget   = budget;
+  reindex();
+  start();
+  if( loggingLevel(INFO) ) {
+    SSDPMemoryReport r = memoryReport();
+    if( _budget != SSDP_NO_BUDGET ) Serial.printf("SSDP::begin: %u of %u bytes used, type index %s\n",(unsigned)r.used,(unsigned)r.budget,
+                                                  ((r.typeIndex)?("built"):("not built")));
+    else Serial.printf("SSDP::begin: %u bytes used, type index %s\n",(unsigned)r.used,((r.typeIndex)?("built"):("not built")));
+  }
+}
+
+void SSDP::start() {
+  beginMulticast(_mUdp);
+  _udp.begin(0);
+#ifdef ESP8266
+  _gotIP = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& /* event */) {this->_rearm = true;});
+#elif defined(ESP32)
+  if( _gotIP == 0 ) _gotIP = WiFi.onEvent([this](WiFiEvent_t /* event */, WiFiEventInfo_t /* info */) {this->_rearm = true;},SSDP_GOT_IP_EVENT);
+#endif
+}
+
+/**
+ *  Rejoin the multicast group and rebind the unicast channel. Responses render LOCATION from the interface address 
+ *  of each request, so there is no other interface dependent state to refresh.
+ */
+void SSDP::rearm() {
+  _rearm = false;
+  _mUdp.stop();
   beginMulticast(_mUdp);
+  _udp.stop();
   _udp.begin(0);
+  if( loggingLevel(INFO) ) Serial.printf("SSDP::rearm: Rejoined multicast group on %s\n",WiFi.localIP().toString().c_str());
+}
+
+/**
+ *  Rebuild the type index of the RootDevice. The index is built by begin(), call reindex() if devices or services are 
+ *  added afterwards. A node provider passed to begin() keeps its own indices. If a change log is enabled, changes
+ *  since the last reindex() are logged under a new generation.
+ */
+void SSDP::reindex() {
+  endPost("reindex");
+  if( (_provider == &_rootProvider) && !_rootProvider.reindex(available(_rootProvider.index().memoryUsed())) && loggingLevel(WARNING) ) 
+    Serial.printf("SSDP::reindex: Type index not built, searching device tree\n");
+  if( _changes.isEnabled() ) {
+    int changes = _changes.sync(_provider);
+    if( loggingLevel(FINE) ) Serial.printf("SSDP::reindex: %d changes, generation %lu\n",changes,(unsigned long)_changes.generation());
+    if( (_budget != SSDP_NO_BUDGET) && (memoryUsed() > _budget) ) {
+      _changes.end();
+      if( loggingLevel(WARNING) ) Serial.printf("SSDP::reindex: Change log exceeds memory budget, sync answered with the whole tree\n");
+    }
+  }
+}
+
+size_t SSDP::memoryUsed() const {
+  return _rootProvider.index().memoryUsed() + _changes.memoryUsed() + _proxy.memoryUsed();
+}
+
+size_t SSDP::available(size_t held) const {
+  if( _budget == SSDP_NO_BUDGET ) return SIZE_MAX;
+  size_t others = memoryUsed() - held;
+  return ((others < _budget)?(_budget - others):(0));
+}
+
+SSDPMemoryReport SSDP::memoryReport() const {
+  SSDPMemoryReport result;
+  result.budget    = _budget;
+  result.used      = memoryUsed();
+  result.typeIndex = _rootProvider.index().isBuilt();
+  result.changeLog = _changes.capacity();
+  result.proxy     = _proxy.capacity();
+  return result;
 }
 
 void SSDP::doSSDP() {
-  doChannel(_mUdp);
-  doChannel(_udp);
+  onTimer();
+  if( !_posting ) doChannel(_mUdp);
+  if( !_posting ) doChannel(_udp);
+}
+
+unsigned long SSDP::nextDeadline() {
+  if( _rearm ) return 0;
+  return _timers.nextDeadline();
+}
+
+void SSDP::onTimer() {
+  if( _rearm ) rearm();
+  _timers.advance();
 }
 
 /**
- *   Send an SSDP request and parse responses with SSDPHandler. Parse responses as long as they are viable, but
- *   don't wait any longer that timeout milliseconds for responses to come in.
+ *  Drain both channels, stopping while deferred responses are being sent
  */
-SSDPResult SSDP::searchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout, boolean ssdpAll) {
-  SSDPResult result = SSDP_OK;
+void SSDP::onReadable() {
+  while( !_posting && doChannel(_mUdp) ) {}
+  while( !_posting && doChannel(_udp) ) {}
+}
+
+#endif
+
+#if SSDP_CLIENT
+SSDPResult SSDP::searchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout, boolean ssdpAll, const char* filter) {
+  return search(ST,textHandler(ST,handler),ifc,SSDP_MULTICAST,timeout,ssdpAll,filter);
+}
+
+/**
+ *   Collect every matching response into results. Records are parsed once, in the receive loop, and held in the result
+ *   set's arena.
+ */
+SSDPResult SSDP::searchRequest(const char* ST, SSDPResponseSet& results, IPAddress ifc, int timeout, boolean ssdpAll, const char* filter) {
+  return search(ST,resultsHandler(ST,results),ifc,SSDP_MULTICAST,timeout,ssdpAll,filter,results.compact());
+}
+
+/**
+ *   Responses are checked in the receive loop and copied into queue; the handler runs from queue.dispatch()
+ */
+SSDPResult SSDP::searchRequest(const char* ST, SSDPHandlerQueue& queue, IPAddress ifc, int timeout, boolean ssdpAll, const char* filter) {
+  SSDPPacketHandler queued = [ST,&queue](const char* packet, int len, IPAddress /* remoteAddr */) {
+    replayResponse(packet,ST,[&queue,packet,len](UPnPBuffer* /* b */) {queue.push(packet,len);});
+  };
+  return search(ST,queued,ifc,SSDP_MULTICAST,timeout,ssdpAll,filter,false,&queue);
+}
+
+SSDPResult SSDP::unicastSearchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, IPAddress target, int timeout, boolean ssdpAll,
+                                      const char* filter) {
+  return search(ST,textHandler(ST,handler),ifc,target,timeout,ssdpAll,filter);
+}
+
+/**
+ *   Send a precomputed search packet. The packet and ST are flash resident and validated at compile time, so the request
+ *   goes out with no formatting; only ST is copied to RAM to match responses.
+ */
+SSDPResult SSDP::searchRequest(const SearchTarget& target, SSDPHandler handler, IPAddress ifc, int timeout) {
+  char st[ST_HEADER_SIZE];
+  strncpy_P(st,target.st(),ST_HEADER_SIZE-1);
+  st[ST_HEADER_SIZE-1] = '\0';
   char txnBuffer[SSDP_BUFFER_SIZE];
-  if( strcmp_P(ST,ST_UPNP_ROOTDEVICE) == 0) {
-     if(ssdpAll) snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_RootAllSearch);
-     else snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_RootSearch);
+  _searchStats = {0,0,0,0,0};
+  return exchange(target.packet(),textHandler(st,handler),ifc,SSDP_MULTICAST,timeout,txnBuffer,SSDP_BUFFER_SIZE);
+}
+
+/**
+ *   A compact request is the SearchTarget packet with an ENC header added, so it is copied to RAM first
+ */
+SSDPResult SSDP::searchRequest(const SearchTarget& target, SSDPResponseSet& results, IPAddress ifc, int timeout) {
+  char st[ST_HEADER_SIZE];
+  strncpy_P(st,target.st(),ST_HEADER_SIZE-1);
+  st[ST_HEADER_SIZE-1] = '\0';
+  char txnBuffer[SSDP_BUFFER_SIZE];
+  PGM_P packet = target.packet();
+  if( results.compact() ) {
+    appendHeader(txnBuffer,SSDP_BUFFER_SIZE,packet,ENC_HEADER_LINE,ENC_COMPACT);
+    packet = txnBuffer;
+  }
+  _searchStats = {0,0,0,0,0};
+  return exchange(packet,resultsHandler(st,results),ifc,SSDP_MULTICAST,timeout,txnBuffer,SSDP_BUFFER_SIZE);
+}
+
+/**
+ *   Track the burst position of each record, then re-request what is missing from each responder by unicast
+ */
+SSDPResult SSDP::searchAllRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout, const char* filter, int retries) {
+  SSDPBurstTracker tracker;
+  uint32_t received = 0;
+  SSDPPacketHandler tracked = [ST,&handler,&tracker,&received](const char* packet, int /* len */, IPAddress remoteAddr) {
+    replayResponse(packet,ST,[&handler,&tracker,&received,remoteAddr](UPnPBuffer* b) {
+      if( tracker.add(b,remoteAddr) ) {
+        received++;
+        handler(b);
+      }
+    });
+  };
+  SSDPResult result = search(ST,tracked,ifc,SSDP_MULTICAST,timeout,true,filter);
+  _searchStats.lost = tracker.missing();
+  received = 0;
+  for( int i=0; (i<retries) && (result == SSDP_OK); i++ ) {
+    int incomplete = tracker.incomplete([ST,&tracked,ifc,&result](IPAddress responder, uint32_t id, const char* missing) {
+      char txnBuffer[SSDP_BUFFER_SIZE];
+      char value[SSDP_HEADER_BUFFER_SIZE];
+      snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_Search,ST);
+      snprintf(value,SSDP_HEADER_BUFFER_SIZE,SSDP_BURST_ID "%lu" SSDP_BURST_MISSING "%s:",(unsigned long)id,missing);
+      appendHeader(txnBuffer,SSDP_BUFFER_SIZE,txnBuffer,BURST_HEADER_LINE,value);
+      if( loggingLevel(FINE) ) Serial.printf("SSDP::searchAllRequest: Re-requesting %s of burst %lu\n",missing,(unsigned long)id);
+      SSDPResult r = exchange(txnBuffer,tracked,ifc,responder,BURST_RETRY_TIMEOUT,txnBuffer,SSDP_BUFFER_SIZE);
+      if( r != SSDP_OK ) result = r;
+    });
+    if( incomplete == 0 ) break;
   }
+/**
+ *  Records delivered on re-request, which may include records added to a burst that was sent again under a new id
+ */
+  _searchStats.recovered = ((received < _searchStats.lost)?(received):(_searchStats.lost));
+  if( (_searchStats.lost > 0) && loggingLevel(FINE) ) Serial.printf("SSDP::searchAllRequest: %lu records lost, %lu recovered\n",
+                                          (unsigned long)_searchStats.lost,(unsigned long)_searchStats.recovered);
+  return result;
+}
+
+/**
+ *   A uuid search with the generation the caller holds. SYNC responses (removed nodes and the closing generation) 
+ *   carry no DESC header, so they are checked here rather than by replayResponse.
+ */
+SSDPResult SSDP::syncRequest(const char* uuid, uint32_t& generation, SSDPHandler handler, IPAddress ifc, boolean& full, int timeout) {
+  char st[ST_HEADER_SIZE];
+  char since[SINCE_HEADER_SIZE];
+  char txnBuffer[SSDP_BUFFER_SIZE];
+  strncpy_P(st,ST_UUID,ST_HEADER_SIZE);
+  strncat(st,uuid,ST_HEADER_SIZE-strlen(st)-1);
+  snprintf(since,SINCE_HEADER_SIZE,"%lu",(unsigned long)generation);
+  snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_Search,st);
+  appendHeader(txnBuffer,SSDP_BUFFER_SIZE,txnBuffer,SINCE_HEADER_LINE,since);
+  _searchStats = {0,0,0,0,0};
+
+  boolean  ended   = false;
+  uint32_t current = generation;
+  full = true;
+  SSDPResult result = exchange(txnBuffer,[&st,&handler,&ended,&current,&full](const char* packet, int /* len */, IPAddress /* remoteAddr */) {
+    UPnPBuffer b(packet);
+    char value[SSDP_HEADER_BUFFER_SIZE];
+    if( !b.isSearchResponse() || !b.headerValue_P(SYNC_LSC_HEADER,value,SSDP_HEADER_BUFFER_SIZE) ) replayResponse(packet,st,handler);
+    else if( !b.headerValue_P(ST_HEADER,value,SSDP_HEADER_BUFFER_SIZE) || (strcmp(value,st) != 0) ) return;
+    else if( b.isRemoved() ) handler(&b);
+    else if( b.generation(current) ) {
+      ended = true;
+      full  = b.isFullSync();
+    }
+  },ifc,SSDP_MULTICAST,timeout,txnBuffer,SSDP_BUFFER_SIZE);
+  if( ended ) generation = current;
+  else if( loggingLevel(FINE) ) Serial.printf("SSDP::syncRequest: No generation from %s\n",st);
+  return result;
+}
+
+/**
+ *   Text responses are parsed into a UPnPBuffer for handler
+ */
+SSDPPacketHandler SSDP::textHandler(const char* ST, SSDPHandler handler) {
+  return [ST,handler](const char* packet, int /* len */, IPAddress /* remoteAddr */) {replayResponse(packet,ST,handler);};
+}
+
+/**
+ *   Results accept both text and compact responses, since responders that do not support the compact encoding answer in text
+ */
+SSDPPacketHandler SSDP::resultsHandler(const char* ST, SSDPResponseSet& results) {
+  return [ST,&results](const char* packet, int len, IPAddress remoteAddr) {
+    if( SSDPCompact::isCompact((const uint8_t*)packet,len) ) {
+      if( (SSDPCompact::decode((const uint8_t*)packet,len,remoteAddr,ST,results) == NULL) && loggingLevel(FINE) ) 
+        Serial.printf("SSDP::searchRequest: Compact response not added\n");
+    }
+    else replayResponse(packet,ST,[&results](UPnPBuffer* b){results.add(b);});
+  };
+}
+
+/**
+ *   Copy packet (flash or RAM) into buffer, adding a header formatted from format and value (flash or RAM) as the last 
+ *   header, replacing the blank line that ends the request. packet may be buffer.
+ */
+void SSDP::appendHeader(char buffer[], size_t size, PGM_P packet, PGM_P format, const char* value) {
+  if( packet != buffer ) strncpy_P(buffer,packet,size);
+  buffer[size-1] = '\0';
+  int len = strlen(buffer);
+  if( len >= 2 ) len -= 2;
+  char header[FILTER_HEADER_SIZE];
+  strncpy_P(header,value,FILTER_HEADER_SIZE-1);
+  header[FILTER_HEADER_SIZE-1] = '\0';
+  snprintf_P(buffer+len,size-len,format,header);
+}
+
+/**
+ *   Format an SSDP request for ST and filter (RootDevice requests without a filter are constant) and exchange it with target (either SSDP_MULTICAST or a device address).
+ */
+SSDPResult SSDP::search(const char* ST, SSDPPacketHandler handler, IPAddress ifc, IPAddress target, int timeout, boolean ssdpAll, 
+                        const char* filter, boolean compact, SSDPHandlerQueue* queue) {
+  SSDPResult result = SSDP_OK;
+  char txnBuffer[SSDP_BUFFER_SIZE];
+  PGM_P packet = txnBuffer;
+  if( strcmp_P(ST,ST_UPNP_ROOTDEVICE) == 0) packet = ((ssdpAll)?(SSDP_RootAllSearch):(SSDP_RootSearch));
   else if((strncmp_P(ST,ST_UUID,5) == 0) ) snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_Search,ST);
   else if((strncmp_P(ST,ST_TYPE,4) == 0))  snprintf_P(txnBuffer,SSDP_BUFFER_SIZE,SSDP_Search,ST);
   else result = SSDP_ERR_ST;
 
-  if( result == SSDP_OK ) {
-  
+/**
+ *  Filter and encoding are added as the last headers, replacing the blank line that ends the request
+ */
+  if( (result == SSDP_OK) && (filter != NULL) && (*filter != '\0') ) {
+    appendHeader(txnBuffer,SSDP_BUFFER_SIZE,packet,FILTER_HEADER_LINE,filter);
+    packet = txnBuffer;
+  }
+  if( (result == SSDP_OK) && compact ) {
+    appendHeader(txnBuffer,SSDP_BUFFER_SIZE,packet,ENC_HEADER_LINE,ENC_COMPACT);
+    packet = txnBuffer;
+  }
+
+  _searchStats = {0,0,0,0,0};
+  if( result == SSDP_OK ) result = exchange(packet,handler,ifc,target,timeout,txnBuffer,SSDP_BUFFER_SIZE,queue);
+  return result;
+}
+
+/**
+ *   Send packet to target and hand responses to handler. Parse responses as long as they are viable, but don't wait 
+ *   any longer that timeout milliseconds for responses to come in. Responses are read as soon as they arrive so handlers 
+ *   can measure response latency; the channel is only polled with a delay when it is empty.
+ *   packet may be in flash or RAM and is written in small chunks, so it may share buffer, which receives responses.
+ *   With a queue, the time the channel would be polled with a delay goes to dispatching one waiting response instead.
+ */
+SSDPResult SSDP::exchange(PGM_P packet, SSDPPacketHandler handler, IPAddress ifc, IPAddress target, int timeout,
+                          char buffer[], size_t size, SSDPHandlerQueue* queue) {
+  SSDPResult result = SSDP_OK;
   WiFiUDP udp;
   int ok = 0;
 
 #ifdef ESP8266
   udp.begin(0);
-  ok = udp.beginPacketMulticast(IPAddress(239,255,255,250),1900,ifc);
+  if( target == SSDP_MULTICAST ) ok = udp.beginPacketMulticast(SSDP_MULTICAST,UDP_PORT,ifc);
+  else ok = udp.beginPacket(target,UDP_PORT);
 #elif defined(ESP32)
   udp.begin(ifc,0);
-  ok = udp.beginPacket(IPAddress(239,255,255,250),1900);
+  ok = udp.beginPacket(target,UDP_PORT);
 #endif
 
   if( ok != 1 ) {
@@ -299,59 +651,78 @@ SSDPResult SSDP::searchRequest(const char* ST, SSDPHandler handler, IPAddress if
     if( loggingLevel(WARNING) ) Serial.printf("SSDP::searchRequest: Error on beginPacket\n");  
   }
   if( result == SSDP_OK ) {
-    int len = strlen(txnBuffer);
-    int sz = udp.write((unsigned char*)txnBuffer,len);
+    int len = strlen_P(packet);
+    uint8_t chunk[64];
+    for( int i=0; i<len; i+=sizeof(chunk) ) {
+      int n = (((len-i)<(int)sizeof(chunk))?(len-i):(sizeof(chunk)));
+      memcpy_P(chunk,packet+i,n);
+      udp.write(chunk,n);
+    }
     ok = udp.endPacket();  
     if( ok != 1 ) {
       result = SSDP_ERR_SEND;
       if( loggingLevel(WARNING) ) Serial.printf("SSDP::searchRequest: Error on endPacket attempt to send %d bytes\n",len);
     }
-    delay(500);
   }
   if( result == SSDP_OK ) {
-      long timeStamp = millis();
-      boolean done = false;
-      while( (millis() - timeStamp < timeout) && !done ) {
+      unsigned long timeStamp = millis();
+      while( millis() - timeStamp < (unsigned long)timeout ) {
          int packetSize = udp.parsePacket();
          if( packetSize > 0 ) {
-           IPAddress remote = udp.remoteIP();
-           txnBuffer[0] = 0;
-           int available = udp.read(txnBuffer, SSDP_BUFFER_SIZE);
-           txnBuffer[available] = 0;
-           UPnPBuffer upnpBuff = UPnPBuffer(txnBuffer);
-           if( upnpBuff.isSearchResponse() ) {
+           buffer[0] = 0;
+           int available = udp.read(buffer, size - 1);
+           if( available < 0 ) available = 0;
+           buffer[available] = 0;
+           _searchStats.received++;
+           if( packetSize > (int)size - 1 ) _searchStats.truncated++;
+/**
+ *         Reset the timestamp if we have an incomming response
+ */
+           if( SSDPCompact::isCompact((const uint8_t*)buffer,available) || UPnPBuffer(buffer).isSearchResponse() ) timeStamp = millis();
+           handler(buffer,available,udp.remoteIP());
+        }
+        else if( (queue != NULL) && !queue->isEmpty() ) queue->dispatch(1);
+        else delay(10);
+      }
+  }
+  udp.stop();
+  return result;
+}
+
 /**
- *           Reset the timestamp if we have an incomming response
+ *   Hand a single search response to handler if it is an LSC response matching ST. This is the per-packet body of
+ *   searchRequest, exposed so captured responses can be replayed without a network.
  */
-             timeStamp = millis();
-           
+boolean SSDP::replayResponse(const char* packet, const char* ST, SSDPHandler handler) {
+  boolean result = false;
+  UPnPBuffer upnpBuff = UPnPBuffer(packet);
+  if( upnpBuff.isSearchResponse() ) {
 /**
- *           The response MUST have an ST header and the ST header MUST match the search request
+ *   The response MUST have an ST header and the ST header MUST match the search request
  */
-             char st_header[ST_HEADER_SIZE];
-             st_header[0] = '\0';
-             if( upnpBuff.headerValue_P(ST_HEADER,st_header,ST_HEADER_SIZE) ) {
-               if( strcmp(st_header,ST) == 0) {  
+    char st_header[ST_HEADER_SIZE];
+    st_header[0] = '\0';
+    if( upnpBuff.headerValue_P(ST_HEADER,st_header,ST_HEADER_SIZE) ) {
+      if( strcmp(st_header,ST) == 0) {  
 /**                
- *               All LSC Devices MUST have a DESC Header in the response
+ *       All LSC Devices MUST have a DESC Header in the response
  */
-                 char name[32];
-                 if( upnpBuff.displayName(name,32) ) handler(&upnpBuff);
-                 else if( loggingLevel(FINE) ) Serial.printf("SSDP::searchRequest: DESC Header not found\n");
-               }
-               else if( loggingLevel(FINE) ) Serial.printf("SSDP::searchRequest: Search Response %s does not match request %s\n",st_header,ST);
-             }
-           }
+        char name[SSDP_NAME_SIZE];
+        if( upnpBuff.displayName(name,SSDP_NAME_SIZE) ) {
+          result = true;
+          handler(&upnpBuff);
         }
-        delay(100);
+        else if( loggingLevel(FINE) ) Serial.printf("SSDP::searchRequest: DESC Header not found\n");
       }
-      udp.stop();
+      else if( loggingLevel(FINE) ) Serial.printf("SSDP::searchRequest: Search Response %s does not match request %s\n",st_header,ST);
     }
   }
   return result;
 }
 
+#endif
 
+#if SSDP_RESPONDER
 /**  Read UDP Channel and respond according to the ST and ST.LEELANAUSOFTWARE.COM headers  
  *   
  *     ST:  upnp:rootdevice        Responds once for each root device
@@ -363,218 +734,781 @@ SSDPResult SSDP::searchRequest(const char* ST, SSDPHandler handler, IPAddress if
  */
 
 boolean SSDP::readChannel(WiFiUDP& channel) {
-  boolean   result       = false;
   IPAddress remoteAddr   = channel.remoteIP();
   int       port         = channel.remotePort();
 
+//  read the packet in chunks, keeping only the request line and headers the responder reads
+  char packet[SSDP_REQUEST_BUFFER_SIZE];
+  char chunk[READ_CHUNK_SIZE];
+  SSDPStreamParser parser(packet,SSDP_REQUEST_BUFFER_SIZE,REQUEST_LINES,((_proxy.isEnabled())?(2):(1)),
+                          REQUEST_HEADERS,sizeof(REQUEST_HEADERS)/sizeof(PGM_P));
+  int available = 0;
+  while( (parser.state() == SSDP_PARSE_MORE) && ((available = channel.read(chunk,READ_CHUNK_SIZE)) > 0) ) parser.parse(chunk,available);
+  _received.received++;
+  if( parser.finish() == SSDP_PARSE_REJECTED ) {
+    _received.rejected++;
+    return false;
+  }
+  if( parser.truncated() ) _received.truncated++;
+  _ifc = arrivalInterface(channel,remoteAddr);
+  if( parser.truncated() && loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: Headers from %s dropped, request too long\n",
+                                                                remoteAddr.toString().c_str());
+  return readPacket(packet,remoteAddr,port);
+}
+
+/**
+ *  Process a datagram received from remoteAddr:port, setting the post handler if a response is required
+ */
+boolean SSDP::readPacket(const char* packet, IPAddress remoteAddr, int port) {
+  boolean   result       = false;
+
 /** We use a post handler so we don't have to hold a both read buffer and write buffer in memory simultaneously.
  *  Post handler defaults to do nothing.
  */
   setPostHandler([]{});
-  
-//  read the packet into readBufffer
-  char txnBuffer[TXN_BUFFER_SIZE + 1];
-  txnBuffer[0] = 0;
-  int available = channel.read(txnBuffer, TXN_BUFFER_SIZE);
-  txnBuffer[available] = 0;
-  UPnPBuffer buffer = UPnPBuffer(txnBuffer);
+  UPnPBuffer buffer = UPnPBuffer(packet);
 
   if( buffer.isSearchRequest() ) {
     char st_lsc_header[ST_LSC_HEADER_SIZE];
     st_lsc_header[0] = '\0';
-    if( buffer.headerValue_P(ST_LSC_HEADER,st_lsc_header,ST_LSC_HEADER_SIZE) ) {  // If the packet has an LSC header field
+    if( buffer.headerValue_P(ST_LSC_HEADER,st_lsc_header,ST_LSC_HEADER_SIZE) && compileFilter(buffer) ) {  // If the packet has an LSC header field
+       negotiateEncoding(buffer);
        char st_header[ST_HEADER_SIZE];
        st_header[0] = '\0';
-       if( buffer.headerValue_P(ST_HEADER,st_header,ST_HEADER_SIZE) ) { // If the packet has an ST header field  
+       char burst_header[SSDP_HEADER_BUFFER_SIZE];
+       if( buffer.headerValue_P(BURST_LSC_HEADER,burst_header,SSDP_HEADER_BUFFER_SIZE) ) { // If this re-requests records of a burst
+          uint32_t    id      = 0;
+          const char* missing = NULL;
+          SSDPBurst*  burst   = ((SSDPBurstTable::parse(burst_header,id,&missing))?(_bursts.find(id,remoteAddr)):(NULL));
+          if( burst != NULL ) {
+             result = true;
+             _requestClass = ((burst->uuid[0] == '\0')?(SSDP_REQ_ROOTDEVICE_ALL):(SSDP_REQ_UUID));
+             memmove(burst_header,missing,strlen(missing)+1);
+             setPostHandler([this,burst,burst_header,remoteAddr,port]{this->postBurst(burst,burst_header,remoteAddr,port);});
+          }
+          else if( loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: burst %lu is not held\n",(unsigned long)id);
+       }
+       else if( buffer.headerValue_P(ST_HEADER,st_header,ST_HEADER_SIZE) ) { // If the packet has an ST header field  
           if( strncmp_P(st_header,ST_UPNP_ROOTDEVICE,15) == 0 ) { // If this is a Root Device search
              result = true;
-             if(strncmp_P(st_lsc_header,SSDP_ALL,8) == 0) setPostHandler([this,st_header,remoteAddr,port]{this->postAllResponse(_root,st_header,remoteAddr,port);});
-             else setPostHandler([this,st_header,remoteAddr,port]{this->postDeviceResponse(_root,st_header,remoteAddr,port);});
+             boolean all = (strncmp_P(st_lsc_header,SSDP_ALL,8) == 0);
+             _requestClass = ((all)?(SSDP_REQ_ROOTDEVICE_ALL):(SSDP_REQ_ROOTDEVICE));
+             if( all && !_compact ) {
+               SSDPBurst* burst = _bursts.start(remoteAddr,st_header,"",_filter);
+               setPostHandler([this,burst,remoteAddr,port]{this->postBurst(burst,NULL,remoteAddr,port);});
+             }
+             else setPostHandler([this,all,st_header,remoteAddr,port]{this->postRoots(st_header,all,remoteAddr,port);});
            }
            else if( strncmp_P(st_header,ST_UUID,5) == 0 ) { // If this is a search by UUID
-             char uuid[UUID_SIZE];
+             char uuid[SSDP_UUID_SIZE];
              // Remove any leading blank chars
              char* uuidBuff = st_header + 5;             
              while( *uuidBuff  == ' ') {uuidBuff++;} 
-             strncpy(uuid,uuidBuff,UUID_SIZE);  
-             UPnPDevice* device = _root->getDevice(uuid);
-             if( device != NULL ) {
+             strncpy(uuid,uuidBuff,SSDP_UUID_SIZE-1);  
+             uuid[SSDP_UUID_SIZE-1] = '\0';
+             SSDPNode node;
+             SSDPNodeProvider* provider = NULL;
+             if( (_provider != NULL) && _provider->find(uuid,node) ) provider = _provider;
+             else if( _proxy.isEnabled() && _proxy.find(uuid,node) ) provider = &_proxy;
+             if( provider != NULL ) {
                 result = true;
-                if(strncmp_P(st_lsc_header,SSDP_ALL,8) == 0) setPostHandler([this,device,st_header,remoteAddr,port]{this->postAllResponse(device,st_header,remoteAddr,port);});
-                else setPostHandler([this,device,st_header,remoteAddr,port]{this->postDeviceResponse(device,st_header,remoteAddr,port);});
+                _requestClass = SSDP_REQ_UUID;
+                char since[SINCE_HEADER_SIZE];
+                if( (provider == _provider) && (node.kind == SSDP_ROOT_RECORD) && _changes.isEnabled() && 
+                    buffer.headerValue_P(SINCE_LSC_HEADER,since,SINCE_HEADER_SIZE) ) {
+                  uint32_t generation = strtoul(since,NULL,10);
+                  setPostHandler([this,node,generation,st_header,remoteAddr,port]{this->postChanges(node,generation,st_header,remoteAddr,port);});
+                }
+                else if( (strncmp_P(st_lsc_header,SSDP_ALL,8) == 0) && !_compact ) {
+                  SSDPBurst* burst = _bursts.start(remoteAddr,st_header,uuid,_filter);
+                  setPostHandler([this,burst,remoteAddr,port]{this->postBurst(burst,NULL,remoteAddr,port);});
+                }
+                else if(strncmp_P(st_lsc_header,SSDP_ALL,8) == 0) setPostHandler([this,provider,node,st_header,remoteAddr,port]{this->postAllResponse(provider,node,st_header,remoteAddr,port);});
+                else setPostHandler([this,provider,node,st_header,remoteAddr,port]{this->postNodeResponse(provider,node,st_header,remoteAddr,port);});
              } 
              else if( loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: device with uuid [%s] does not exist\n",uuid);    
           }
+          else if( (strncmp_P(st_header,ST_TYPE,4) == 0) && !SSDPTypeIndex::isValidPattern(st_header) ) {
+            if( loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: ST has more than %d '*' runs\n",SSDP_PATTERN_STARS);
+          }
           else if(strncmp_P(st_header,ST_TYPE,4) == 0) { // If this is a search by device/service type
             result = true;      
-            setPostHandler([this,st_header,remoteAddr,port]{this->postAllMatching(_root,st_header,remoteAddr,port);});
+            _requestClass = SSDP_REQ_URN;
+            setPostHandler([this,st_header,remoteAddr,port]{this->postAllMatching(st_header,remoteAddr,port);});
           }
        }
        else if( loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: Packet does not have ST header\n");
     }
   }  
+  else if( buffer.isNotify() && _proxy.isEnabled() ) readRegister(buffer,remoteAddr);
   return result;  
 }
 
-void SSDP::doChannel(WiFiUDP& channel) {
+/**
+ *  Add (or remove) the node in an LSC register message to the proxy table. Register messages need no response.
+ */
+void SSDP::readRegister(UPnPBuffer& buffer, IPAddress remoteAddr) {
+  char nts[NTS_HEADER_SIZE];
+  nts[0] = '\0';
+  if( !buffer.headerValue_P(NTS_HEADER,nts,NTS_HEADER_SIZE) ) return;
+  if( strcmp_P(nts,NTS_REGISTER) == 0 ) {
+    int     rejected = _proxy.rejected();
+    boolean added    = _proxy.add(&buffer,remoteAddr);
+    if( (_proxy.rejected() != rejected) && loggingLevel(WARNING) ) 
+      Serial.printf("SSDP::readRegister: Registration from %s rejected, device is registered with another token\n",remoteAddr.toString().c_str());
+    else if( !added && loggingLevel(WARNING) ) Serial.printf("SSDP::readRegister: Registration from %s not added\n",remoteAddr.toString().c_str());
+  }
+  else if( strcmp_P(nts,NTS_UNREGISTER) == 0 ) {
+    char usn[SSDP_HEADER_BUFFER_SIZE];
+    usn[0] = '\0';
+    if( buffer.headerValue_P(USN_HEADER,usn,SSDP_HEADER_BUFFER_SIZE) && (strncmp_P(usn,ST_UUID,5) == 0) ) {
+      char* delim = strstr_P(usn,DELIM);
+      if( delim != NULL ) *delim = '\0';
+      int removed = _proxy.remove(usn+5,SSDPProxy::ownerKey(&buffer,remoteAddr));
+      if( removed < 0 ) {
+        if( loggingLevel(WARNING) ) Serial.printf("SSDP::readRegister: Unregister of %s from %s rejected, device is registered with another token\n",
+                                                  usn+5,remoteAddr.toString().c_str());
+      }
+      else if( loggingLevel(FINE) ) Serial.printf("SSDP::readRegister: Removed %d proxy entries for %s\n",removed,usn+5);
+    }
+  }
+}
+
+/**
+ *  Compile the request's FILTER.LEELANAUSOFTWARE.COM header, if any, into _filter for the post handler. Returns false if 
+ *  the filter is malformed, in which case the request is ignored.
+ */
+boolean SSDP::compileFilter(UPnPBuffer& buffer) {
+  boolean result = true;
+  char filter[FILTER_HEADER_SIZE];
+  filter[0] = '\0';
+  if( buffer.headerValue_P(FILTER_LSC_HEADER,filter,FILTER_HEADER_SIZE) ) {
+    result = _filter.compile(filter);
+    if( !result && loggingLevel(FINE) ) Serial.printf("SSDP::readChannel: Malformed filter [%s]\n",filter);
+  }
+  else _filter.clear();
+  return result;
+}
+
+/**
+ *  Responses are compact if the request's ENC.LEELANAUSOFTWARE.COM header names an encoding we support, otherwise text
+ */
+boolean SSDP::negotiateEncoding(UPnPBuffer& buffer) {
+  char enc[ENC_HEADER_SIZE];
+  enc[0] = '\0';
+  _compact = buffer.headerValue_P(ENC_LSC_HEADER,enc,ENC_HEADER_SIZE) && (strcmp_P(enc,ENC_COMPACT) == 0);
+  return _compact;
+}
+
+boolean SSDP::doChannel(WiFiUDP& channel) {
 /**
  * if there's data available, read a packet. If a response is required, post it.
  */
   int packetSize = channel.parsePacket();
   boolean reply = false;
+  unsigned long arrival = micros();
   if (packetSize) {
     reply = readChannel(channel);
   }
   if( reply ) {
+    postResponses(arrival);
+  }
+  return (packetSize > 0);
+}
+
+boolean SSDP::replay(const char* packet, IPAddress remoteAddr, int port) {
+  unsigned long arrival = micros();
+  endPost("replay");
+  _ifc = interfaceAddress(remoteAddr);
+  boolean reply = readPacket(packet,remoteAddr,port);
+  if( reply ) postResponses(arrival);
+  return reply;
+}
+
+/**
+ *  Run the post handler for a request that arrived at arrival (micros) and record its latency. Queue wait is the time 
+ *  from arrival until the first response starts sending; latency is the time from arrival until the last response is 
+ *  sent, and includes pacing between responses.
+ */
+void SSDP::postResponses(unsigned long arrival) {
+  _arrival   = arrival;
+  _responses = 0;
+  if( _deferred && !_sendHandler ) {
+    _planning   = true;
+    _planFailed = false;
     _postHandler();
+    _planning   = false;
+    if( _planFailed ) {
+      if( loggingLevel(WARNING) ) Serial.printf("SSDP::postResponses: Unable to hold more than %d deferred responses, pacing by delay\n",_planSize);
+      endPost(NULL);
+      _postHandler();
+      recordLatency();
+    }
+    else if( _planSize > 0 ) {
+      _posting  = true;
+      _postNext = 0;
+      continuePost();
+    }
+  }
+  else {
+    _postHandler();
+    recordLatency();
   }
 }
 
 /**
- *      ST: 
- *      USN: service USN
- *      UPN.LEELANAUSOFTWARE.COM: service UPN
- *      DESC.LEELANAUSOFTWARE.COM: devices:num-devices:services:num-services on a device response and not present on a service response
- *      
- *   
+ *  Deferred pacing walks the provider once, when the post starts, and collects the responses with their nodes in a
+ *  plan. Each call sends the response at _postNext and schedules the next call DELAY milliseconds later on the timing
+ *  wheel, or follows a blocking delay if no timer is free. Plan entries point into the provider and the proxy table,
+ *  so reindex(), enableProxy(), disableProxy() and replay() abandon a post in progress (see endPost).
  */
-void SSDP::postDeviceResponse(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port) {
-  char txnBuffer[TXN_BUFFER_SIZE + 1];
-  txnBuffer[0] = '\0';
-  RootDevice* r = d->asRootDevice();
-  UPnPDevice* p = d->parentAsDevice();
+void SSDP::continuePost() {
+  _postTimer = SSDP_NO_TIMER;
+  while( _posting ) {
+    const SSDPPostStep& step = _plan[_postNext++];
+    if( step.provider != NULL ) sendNodeResponse(step.provider,step.node,_postST,_postRemote,_postPort,_postBurst,step.index);
+    else sendSyncResponse(_postST,step.node.kind,step.node.uuid,step.node.type,step.sync,_postRemote,_postPort);
+    if( _postNext >= _planSize ) {
+      endPost(NULL);
+      recordLatency();
+      return;
+    }
+    _postTimer = _timers.schedule(DELAY,[this]() {this->continuePost();});
+    if( _postTimer != SSDP_NO_TIMER ) return;
+    if( loggingLevel(WARNING) ) Serial.printf("SSDP::continuePost: No free timer, pacing by delay\n");
+    delay(DELAY);
+  }
+}
 
-/**  
- *  Device location is set to the network adapter receiving the incoming request (either localIP or softAPIP)
+/**
+ *  Cancel the pending response of the post in progress and release its plan. reason is logged if a post was cut
+ *  short, NULL when it is done.
  */
-  IPAddress ifc = interfaceAddress(remoteAddr);
-  
+void SSDP::endPost(const char* reason) {
+  if( _posting && (reason != NULL) && loggingLevel(WARNING) ) 
+    Serial.printf("SSDP::endPost: %d of %d deferred responses not sent, %s\n",_planSize-_postNext,_planSize,reason);
+  if( _postTimer != SSDP_NO_TIMER ) _timers.cancel(_postTimer);
+  _postTimer = SSDP_NO_TIMER;
+  _posting   = false;
+  _postNext  = 0;
+  _planSize  = 0;
+  _planCap   = 0;
+  if( _plan != NULL ) free(_plan);
+  _plan = NULL;
+}
+
 /**
- *   If this device is a RootDevice use the Root template, otherwise use the Device template
- *   Note that RootDevice location does not include the root target, so will default to RootDevice::displayRoot
+ *  Add a response to the plan of a deferred post, growing it as needed. Returns false, and marks the plan failed, if
+ *  it cannot grow.
  */
-  char locBuff[128];
-  locBuff[0] = '\0';
-  if( r != NULL ) r->rootLocation(locBuff,128,ifc);
-  else d->location(locBuff,128,ifc); 
-  
-  if( (r != NULL) ) 
-    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,ROOT_RESPONSE,locBuff,st,d->uuid(),d->getType(),d->getDisplayName(),r->numDevices(),r->numServices());  
-  else if( p != NULL ) 
-    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,DEVICE_RESPONSE,locBuff,st,d->uuid(),d->getType(),d->getDisplayName(),d->numServices(),p->uuid());
-  else 
-    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,ROOT_RESPONSE,locBuff,st,d->uuid(),d->getType(),d->getDisplayName(),0,d->numServices()); // Error state, non-root should have a parent
+boolean SSDP::plan(SSDPNodeProvider* provider, const SSDPNode& node, PGM_P sync, const char* st, IPAddress remoteAddr, int port,
+                   const SSDPBurst* burst, int index) {
+  if( _planFailed ) return false;
+  if( _planSize == _planCap ) {
+    int cap = ((_planCap == 0)?(8):(2*_planCap));
+    SSDPPostStep* grown = (SSDPPostStep*)realloc(_plan,cap*sizeof(SSDPPostStep));
+    if( grown == NULL ) {
+      _planFailed = true;
+      return false;
+    }
+    _plan    = grown;
+    _planCap = cap;
+  }
+  SSDPPostStep& step = _plan[_planSize++];
+  step.provider = provider;
+  step.node     = node;
+  step.sync     = sync;
+  step.index    = index;
+  _postST       = st;
+  _postBurst    = burst;
+  _postRemote   = remoteAddr;
+  _postPort     = port;
+  return true;
+}
+
+void SSDP::recordLatency() {
+  if( _responses > 0 ) _latency[_requestClass].record(_lastSent - _arrival);
+}
+
+const SSDPHistogram& SSDP::responseLatency(SSDPRequestClass c) const {
+  if( (c < 0) || (c >= SSDP_REQ_CLASSES) ) c = SSDP_REQ_ROOTDEVICE;
+  return _latency[c];
+}
 
-  int len = strlen(txnBuffer);
+void SSDP::resetStats() {
+  for( int i=0; i<SSDP_REQ_CLASSES; i++ ) _latency[i].reset();
+  _queueWait.reset();
+  _sendTime.reset();
+  _received = {0,0,0,0,0};
+}
+
+/**
+ *  Send a rendered response to remoteAddr:port, or hand it to the send handler if one is set. Responses are paced
+ *  with DELAY milliseconds between packets on the network; a send handler is not paced.
+ */
+void SSDP::sendResponse(const char* packet, int len, IPAddress remoteAddr, int port) {
+  unsigned long start = micros();
+  if( _responses++ == 0 ) _queueWait.record(start - _arrival);
+  if( _sendHandler ) {
+    _sendHandler(packet,len,remoteAddr,port);
+    _lastSent = micros();
+    _sendTime.record(_lastSent - start);
+    return;
+  }
   int ok = _udp.beginPacket(remoteAddr, port);
   if( ok != 1 ) {
-    if( loggingLevel(WARNING) ) Serial.printf("postDeviceResponse: Error on beginPacket\n");
+    if( loggingLevel(WARNING) ) Serial.printf("SSDP::sendResponse: Error on beginPacket\n");
   }
-  int sz = _udp.write((unsigned char*)txnBuffer,len);
+  _udp.write((const uint8_t*)packet,len);
   ok = _udp.endPacket();
   if( ok != 1 ) {
-    if( loggingLevel(WARNING) ) Serial.printf("postDeviceResponse: Error on endPacket attempt to send %d bytes\",len");
+    if( loggingLevel(WARNING) ) Serial.printf("SSDP::sendResponse: Error on endPacket attempt to send %d bytes\n",len);
   }
-  delay(500);
+  _lastSent = micros();
+  _sendTime.record(_lastSent - start);
+  if( !_posting ) delay(DELAY);
 }
 
-void SSDP::postServiceResponse(UPnPService* s, const char* st, IPAddress remoteAddr, int port ) {
-/**  
- *  Service location is set to the network adapter receiving the incoming request (either localIP or softAPIP)
+/**
+ *  Call fn on the node provider and, when proxy mode is enabled, the proxy table
  */
-  IPAddress ifc = interfaceAddress(remoteAddr);
-  
+void SSDP::forEachProvider(std::function<void(SSDPNodeProvider*)> fn) {
+  if( _provider != NULL ) fn(_provider);
+  if( _proxy.isEnabled() ) fn(&_proxy);
+}
+
+/**
+ *  Evaluate the request filter on node. A service term matches a device if any of its services has a matching type.
+ */
+boolean SSDP::nodeMatches(SSDPNodeProvider* provider, const SSDPNode& node) {
+  if( _filter.isEmpty() ) return true;
+  if( !_filter.matches(node.name,node.depth) ) return false;
+  if( node.kind == SSDP_SERVICE_RECORD ) return _filter.matchesService(node.type);
+  if( !_filter.hasServiceTerm() ) return true;
+  boolean found = false;
+  provider->children(node,[this,&found](const SSDPNode& child) {
+    if( (child.kind == SSDP_SERVICE_RECORD) && this->_filter.matchesService(child.type) ) found = true;
+  });
+  return found;
+}
+
+/**
+ *   Post the response for node if it passes the request filter. Deferred posts add it to the plan (see continuePost).
+ */
+void SSDP::postNodeResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port,
+                            const SSDPBurst* burst, int index) {
+  if( !nodeMatches(provider,node) ) return;
+  if( _planning ) plan(provider,node,NULL,st,remoteAddr,port,burst,index);
+  else sendNodeResponse(provider,node,st,remoteAddr,port,burst,index);
+}
+
+/**
+ *   Render the response for node, using the Root, Device or Service template by node kind, or the compact encoding
+ *   if the request asked for it.
+ *      ST: ST from M-SEARCH request
+ *      USN: device or service USN
+ *      DESC.LEELANAUSOFTWARE.COM: devices:num-devices:services:num-services on a device response and not present on a service response
+ */
+void SSDP::sendNodeResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port,
+                            const SSDPBurst* burst, int index) {
   char txnBuffer[TXN_BUFFER_SIZE + 1];
   txnBuffer[0] = '\0';
-  UPnPDevice* p = s->parentAsDevice();
-  char locBuff[128];
+
+/**  
+ *  Location is set to the network adapter receiving the incoming request (either localIP or softAPIP), found once per
+ *  request by arrivalInterface()
+ */
+  char locBuff[SSDP_LOC_BUFFER_SIZE];
   locBuff[0] = '\0';
-  s->location(locBuff,128,ifc);
-  if( p != NULL ) {
-    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,SERVICE_RESPONSE,locBuff,st,s->getType(),p->uuid(),s->getDisplayName(),p->uuid());
+  provider->location(node,locBuff,SSDP_LOC_BUFFER_SIZE,_ifc);
+
+  if( _compact ) {
+    SSDPCompactFields f;
+    f.kind        = node.kind;
+    f.uuid        = node.uuid;
+    f.puuid       = node.puuid;
+    f.type        = node.type;
+    f.st          = st;
+    f.name        = node.name;
+    f.location    = locBuff;
+    f.numDevices  = node.numDevices;
+    f.numServices = node.numServices;
+    size_t len = SSDPCompact::encode((uint8_t*)txnBuffer,TXN_BUFFER_SIZE,f,_ifc);
+    if( len > 0 ) sendResponse(txnBuffer,len,remoteAddr,port);
+    return;
   }
-  int len = strlen(txnBuffer);
- 
-  int ok = _udp.beginPacket(remoteAddr, port);
-  if( ok != 1 ) {
-    if( loggingLevel(WARNING) ) Serial.printf("postServiceResponse: Error on beginPacket\n");
+
+  if( node.kind == SSDP_ROOT_RECORD ) 
+    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,ROOT_RESPONSE,locBuff,st,node.uuid,node.type,node.name,node.numDevices,node.numServices);  
+  else if( node.kind == SSDP_DEVICE_RECORD ) 
+    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,DEVICE_RESPONSE,locBuff,st,node.uuid,node.type,node.name,node.numServices,node.puuid);
+  else 
+    snprintf_P(txnBuffer,TXN_BUFFER_SIZE,SERVICE_RESPONSE,locBuff,st,node.type,node.uuid,node.name,node.puuid);
+
+/**
+ *  Records of a burst carry their position as the last header
+ */
+  if( burst != NULL ) {
+    char* end = strstr_P(txnBuffer,HEADER_END);
+    if( end != NULL ) snprintf_P(end+2,TXN_BUFFER_SIZE-(end+2-txnBuffer),BURST_RECORD,(unsigned long)burst->id,index,burst->total);
   }
-  int sz = _udp.write((unsigned char*)txnBuffer,len);
-  ok = _udp.endPacket();  
-  if( ok != 1 ) {
-    if( loggingLevel(WARNING) ) Serial.printf("postServiceResponse: Error on endPacket attempt to send %d bytes\n",len);
+  sendResponse(txnBuffer,strlen(txnBuffer),remoteAddr,port);
+}
+
+/**
+ *  Post a response for node, each of its services, and each embedded device and its services
+ */
+void SSDP::postAllResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port ) {
+  postNodeResponse(provider,node,st,remoteAddr,port);
+  provider->children(node,[this,provider,st,remoteAddr,port](const SSDPNode& child) {
+    if( child.kind == SSDP_SERVICE_RECORD ) this->postNodeResponse(provider,child,st,remoteAddr,port);
+    else this->postAllResponse(provider,child,st,remoteAddr,port);
+  });
+}
+
+/**
+ *  Visit node and every node below it in the order postAllResponse posts them
+ */
+void SSDP::walkAll(SSDPNodeProvider* provider, const SSDPNode& node, std::function<void(SSDPNodeProvider*,const SSDPNode&)>& fn) {
+  fn(provider,node);
+  provider->children(node,[provider,&fn](const SSDPNode& child) {
+    if( child.kind == SSDP_SERVICE_RECORD ) fn(provider,child);
+    else walkAll(provider,child,fn);
+  });
+}
+
+/**
+ *  The records of a burst: every node of every root for upnp:rootdevice, or of the device with uuid, that passes the
+ *  burst's filter
+ */
+void SSDP::forEachBurstNode(const SSDPBurst* burst, std::function<void(SSDPNodeProvider*,const SSDPNode&)> fn) {
+  _filter = burst->filter;
+  std::function<void(SSDPNodeProvider*,const SSDPNode&)> matching = [this,&fn](SSDPNodeProvider* provider, const SSDPNode& node) {
+    if( this->nodeMatches(provider,node) ) fn(provider,node);
+  };
+  if( burst->uuid[0] == '\0' ) {
+    forEachProvider([&matching](SSDPNodeProvider* provider) {
+      provider->roots([provider,&matching](const SSDPNode& root) {walkAll(provider,root,matching);});
+    });
+  }
+  else {
+    SSDPNode node;
+    if( (_provider != NULL) && _provider->find(burst->uuid,node) ) walkAll(_provider,node,matching);
+    else if( _proxy.isEnabled() && _proxy.find(burst->uuid,node) ) walkAll(&_proxy,node,matching);
   }
-  delay(500);
 }
 
-void SSDP::postAllResponse(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port ) {
-  postDeviceResponse(d, st, remoteAddr, port );
-  UPnPService** services = d->services();
-  for(int i=0; i<d->numServices(); i++ ) {
-    postServiceResponse(services[i],st,remoteAddr, port);
+/**
+ *  Post every record of burst, or only the records listed in missing. The records are counted and hashed first; if a
+ *  re-request finds them changed, the whole burst is posted again under a new id.
+ */
+void SSDP::postBurst(SSDPBurst* burst, const char* missing, IPAddress remoteAddr, int port) {
+  int      total = 0;
+  uint32_t hash  = 2166136261UL;
+  forEachBurstNode(burst,[&total,&hash](SSDPNodeProvider* /* provider */, const SSDPNode& node) {
+    for( const char* p = node.uuid; *p != '\0'; p++ ) {hash ^= (uint8_t)*p; hash *= 16777619UL;}
+    for( const char* p = node.type; *p != '\0'; p++ ) {hash ^= (uint8_t)*p; hash *= 16777619UL;}
+    total++;
+  });
+  if( (missing != NULL) && ((total != burst->total) || (hash != burst->hash)) ) {
+    if( loggingLevel(FINE) ) Serial.printf("SSDP::postBurst: burst %lu changed, sending all records\n",(unsigned long)burst->id);
+    _bursts.renew(burst);
+    missing = NULL;
   }
-  RootDevice* r = d->asRootDevice();
-  if( r != NULL ) {
-    UPnPDevice** devices = r->devices();
-    for( int i=0; i<r->numDevices(); i++ ) {
-      postAllResponse(devices[i],st,remoteAddr, port);
+  burst->total = total;
+  burst->hash  = hash;
+  int index = 0;
+  forEachBurstNode(burst,[this,burst,missing,&index,remoteAddr,port](SSDPNodeProvider* provider, const SSDPNode& node) {
+    if( (missing == NULL) || SSDPBurstTable::listed(missing,index) ) this->postNodeResponse(provider,node,burst->st,remoteAddr,port,burst,index);
+    index++;
+  });
+}
+
+/**
+ *  upnp:rootdevice - each RootDevice, or with ssdp:all every device and service
+ */
+void SSDP::postRoots(const char* st, boolean all, IPAddress remoteAddr, int port) {
+  forEachProvider([this,st,all,remoteAddr,port](SSDPNodeProvider* provider) {
+    provider->roots([this,provider,st,all,remoteAddr,port](const SSDPNode& root) {
+      if( all ) this->postAllResponse(provider,root,st,remoteAddr,port);
+      else this->postNodeResponse(provider,root,st,remoteAddr,port);
+    });
+  });
+}
+
+/**
+ *  Post a response for each device and service whose type matches st, which may be a type pattern containing '*'.
+ */
+void SSDP::postAllMatching(const char* st, IPAddress remoteAddr, int port ) {
+  int matched = 0;
+  forEachProvider([this,st,remoteAddr,port,&matched](SSDPNodeProvider* provider) {
+    matched += provider->match(st,[this,provider,st,remoteAddr,port](const SSDPNode& node) {
+      this->postNodeResponse(provider,node,st,remoteAddr,port);
+    });
+  });
+  if( loggingLevel(FINEST) ) Serial.printf("SSDP::postAllMatching: %d devices and services match %s\n",matched,st);
+}
+
+/**
+ *  Proxy mode. Entries registered by sleeping devices are served by the proxy table as a node provider, so they are
+ *  answered with the same templates as hosted devices, with the sleeping device's own LOCATION.
+ */
+boolean SSDP::enableProxy(int capacity) {
+  endPost("proxy table reset");
+  _proxy.end();
+  if( _budget != SSDP_NO_BUDGET ) {
+    size_t fit = available(0)/sizeof(SSDPProxyEntry);
+    if( fit < (size_t)capacity ) {
+      if( loggingLevel(WARNING) ) Serial.printf("SSDP::enableProxy: Memory budget allows %u of %d proxy entries\n",(unsigned)fit,capacity);
+      capacity = fit;
     }
   }
+  boolean result = _proxy.begin(capacity);
+  if( !result && loggingLevel(WARNING) ) Serial.printf("SSDP::enableProxy: Unable to allocate %d proxy entries\n",capacity);
+  return result;
 }
 
-void SSDP::postAllMatching(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port ) {
-  if( loggingLevel(FINEST) ) {
-    Serial.printf("SSDP::postAllMatching: Searching for device or service %s\n", st);
-    Serial.printf("                       Device type is  %s\n", d->getType());
-    if( d->isType(st) )  Serial.printf("                       Device type is a match, posting response\n");
-    else  Serial.printf("                       Device type is NOT a match\n");
+/**
+ *  Delta sync. The first sync only snapshots the provider, so the log starts empty at the current generation.
+ */
+boolean SSDP::enableChangeLog(int capacity) {
+  _changes.end();
+  if( _budget != SSDP_NO_BUDGET ) {
+    size_t fit = available(0)/sizeof(SSDPChange);
+    if( fit < (size_t)capacity ) {
+      if( loggingLevel(WARNING) ) Serial.printf("SSDP::enableChangeLog: Memory budget allows %u of %d changes\n",(unsigned)fit,capacity);
+      capacity = fit;
+    }
   }
-  if(d->isType(st)) postDeviceResponse(d, st, remoteAddr, port );
-  UPnPService** services = d->services();
-  Serial.printf("                       Searching services for device type %s\n", d->getType());
-  for(int i=0; i<d->numServices(); i++ ) {
-    if( loggingLevel(FINEST) ) {
-       Serial.printf("                            Service type is  %s\n", services[i]->getType());
-       if( services[i]->isType(st) )  Serial.printf("                            Service type is a match, posting response\n");
-       else  Serial.printf("                            Service type is NOT a match\n");
+  boolean result = _changes.begin(capacity);
+  if( result ) {
+    _changes.sync(_provider);
+
+/**
+ *  The snapshot is sized by the provider's nodes, so it is only known after the first sync
+ */
+    if( (_budget != SSDP_NO_BUDGET) && (memoryUsed() > _budget) ) {
+      _changes.end();
+      result = false;
+      if( loggingLevel(WARNING) ) Serial.printf("SSDP::enableChangeLog: Snapshot exceeds memory budget, change log not enabled\n");
     }
-    if( services[i]->isType(st) ) postServiceResponse(services[i],st,remoteAddr,port);
   }
-  RootDevice* r = d->asRootDevice();
-  if( r != NULL ) {
-    UPnPDevice** devices = r->devices();
-    for( int i=0; i<r->numDevices(); i++ ) {
-      postAllMatching(devices[i],st,remoteAddr,port);
+  else if( loggingLevel(WARNING) ) Serial.printf("SSDP::enableChangeLog: Unable to allocate %d changes\n",capacity);
+  return result;
+}
+
+/**
+ *  Post the latest change to each node of root after since, or the whole tree if the log does not reach back to since,
+ *  and end with the current generation. Nodes added or changed are answered as for a search, from their current state.
+ */
+void SSDP::postChanges(const SSDPNode& root, uint32_t since, const char* st, IPAddress remoteAddr, int port) {
+  boolean delta = _changes.covers(since);
+  if( delta ) {
+    int changes = _changes.changes(root.uuid,since,[this,st,remoteAddr,port](const SSDPChange& c) {
+      SSDPNode node;
+      if( (c.change != SSDP_NODE_REMOVED) && this->findNode(c.kind,c.uuid,c.type,node) ) this->postNodeResponse(this->_provider,node,st,remoteAddr,port);
+      else this->postSyncResponse(st,c.kind,c.uuid,c.type,SYNC_REMOVED,remoteAddr,port);
+    });
+    if( loggingLevel(FINEST) ) Serial.printf("SSDP::postChanges: %d changes since generation %lu\n",changes,(unsigned long)since);
+  }
+  else postAllResponse(_provider,root,st,remoteAddr,port);
+  postSyncResponse(st,root.kind,root.uuid,root.type,((delta)?(SYNC_DELTA):(SYNC_FULL)),remoteAddr,port);
+}
+
+void SSDP::postSyncResponse(const char* st, SSDPRecordKind kind, const char* uuid, const char* type, PGM_P sync, IPAddress remoteAddr, int port) {
+  if( _planning ) {
+    SSDPNode node = {kind,uuid,"",type,"",0,0,0,NULL};
+    plan(NULL,node,sync,st,remoteAddr,port,NULL,0);
+  }
+  else sendSyncResponse(st,kind,uuid,type,sync,remoteAddr,port);
+}
+
+void SSDP::sendSyncResponse(const char* st, SSDPRecordKind kind, const char* uuid, const char* type, PGM_P sync, IPAddress remoteAddr, int port) {
+  char txnBuffer[TXN_BUFFER_SIZE + 1];
+  char value[8];
+  strncpy_P(value,sync,sizeof(value)-1);
+  value[sizeof(value)-1] = '\0';
+  unsigned long generation = _changes.generation();
+/**
+ *  Service USNs keep the field order of a service search response
+ */
+  if( kind == SSDP_SERVICE_RECORD ) snprintf_P(txnBuffer,TXN_BUFFER_SIZE,SYNC_RESPONSE,st,type,uuid,generation,value);
+  else snprintf_P(txnBuffer,TXN_BUFFER_SIZE,SYNC_RESPONSE,st,uuid,type,generation,value);
+  sendResponse(txnBuffer,strlen(txnBuffer),remoteAddr,port);
+}
+
+boolean SSDP::findNode(SSDPRecordKind kind, const char* uuid, const char* type, SSDPNode& node) {
+  SSDPNode device;
+  if( (_provider == NULL) || !_provider->find(uuid,device) ) return false;
+  if( kind != SSDP_SERVICE_RECORD ) {
+    node = device;
+    return (device.kind == kind) && (strcmp(device.type,type) == 0);
+  }
+  boolean found = false;
+  _provider->children(device,[type,&node,&found](const SSDPNode& child) {
+    if( !found && (child.kind == SSDP_SERVICE_RECORD) && (strcmp(child.type,type) == 0) ) {
+      node  = child;
+      found = true;
     }
+  });
+  return found;
+}
+
+SSDPResult SSDP::registerWithProxy(RootDevice* root, IPAddress proxy, int ttl, const char* token) {
+  SSDPRootDeviceProvider provider;
+  provider.setRoot(root);
+  return registerWithProxy(&provider,proxy,ttl,token);
+}
+
+/**
+ *  Register every node of provider with the SSDP proxy at proxy for ttl seconds. Messages are spaced REGISTER_DELAY 
+ *  milliseconds apart so the proxy's receive queue is not overrun. Without a token, the station MAC address is sent.
+ */
+SSDPResult SSDP::registerWithProxy(SSDPNodeProvider* provider, IPAddress proxy, int ttl, const char* token) {
+  SSDPResult result = SSDP_OK;
+  String mac = WiFi.macAddress();
+  if( token == NULL ) token = mac.c_str();
+  WiFiUDP udp;
+  udp.begin(0);
+  IPAddress ifc = interfaceAddress(proxy);
+  provider->roots([&udp,provider,proxy,ifc,ttl,token,&result](const SSDPNode& root) {
+    if( result == SSDP_OK ) result = registerNode(udp,provider,root,proxy,ifc,ttl,token);
+  });
+  udp.stop();
+  return result;
+}
+
+SSDPResult SSDP::unregisterWithProxy(RootDevice* root, IPAddress proxy, const char* token) {
+  SSDPRootDeviceProvider provider;
+  provider.setRoot(root);
+  return unregisterWithProxy(&provider,proxy,token);
+}
+
+/**
+ *  Remove every RootDevice of provider, and everything below it, from the proxy, for example when the device is retired
+ */
+SSDPResult SSDP::unregisterWithProxy(SSDPNodeProvider* provider, IPAddress proxy, const char* token) {
+  SSDPResult result = SSDP_OK;
+  String mac = WiFi.macAddress();
+  if( token == NULL ) token = mac.c_str();
+  WiFiUDP udp;
+  udp.begin(0);
+  IPAddress ifc = interfaceAddress(proxy);
+  provider->roots([&udp,provider,proxy,ifc,token,&result](const SSDPNode& node) {
+    if( result == SSDP_OK ) result = sendRegister(udp,provider,node,proxy,ifc,0,token);
+  });
+  udp.stop();
+  return result;
+}
+
+SSDPResult SSDP::registerNode(WiFiUDP& udp, SSDPNodeProvider* provider, const SSDPNode& node, IPAddress proxy, IPAddress ifc, int ttl,
+                               const char* token) {
+  SSDPResult result = sendRegister(udp,provider,node,proxy,ifc,ttl,token);
+  provider->children(node,[&udp,provider,proxy,ifc,ttl,token,&result](const SSDPNode& child) {
+    if( result == SSDP_OK ) result = registerNode(udp,provider,child,proxy,ifc,ttl,token);
+  });
+  return result;
+}
+
+/**
+ *  Send the register message for node. A ttl of 0 sends lsc:unregister.
+ */
+SSDPResult SSDP::sendRegister(WiFiUDP& udp, SSDPNodeProvider* provider, const SSDPNode& node, IPAddress proxy, IPAddress ifc, int ttl,
+                               const char* token) {
+  char txnBuffer[TXN_BUFFER_SIZE + 1];
+  char locBuff[SSDP_LOC_BUFFER_SIZE];
+  char desc[DESC_SIZE];
+  locBuff[0] = '\0';
+  desc[0]    = '\0';
+  provider->location(node,locBuff,SSDP_LOC_BUFFER_SIZE,ifc);
+  if( node.kind == SSDP_ROOT_RECORD ) snprintf_P(desc,DESC_SIZE,ROOT_DESC,node.name,node.numDevices,node.numServices);
+  else if( node.kind == SSDP_DEVICE_RECORD ) snprintf_P(desc,DESC_SIZE,DEVICE_DESC,node.name,node.numServices,node.puuid);
+  else snprintf_P(desc,DESC_SIZE,SERVICE_DESC,node.name,node.puuid);
+  char nts[NTS_HEADER_SIZE];
+  strncpy_P(nts,((ttl > 0)?(NTS_REGISTER):(NTS_UNREGISTER)),NTS_HEADER_SIZE);
+  int len = snprintf_P(txnBuffer,TXN_BUFFER_SIZE,REGISTER_MESSAGE,proxy[0],proxy[1],proxy[2],proxy[3],ttl,locBuff,node.type,nts,
+                       node.uuid,node.type,desc,token);
+  if( len >= TXN_BUFFER_SIZE ) len = TXN_BUFFER_SIZE - 1;
+
+  if( udp.beginPacket(proxy,UDP_PORT) != 1 ) {
+    if( loggingLevel(WARNING) ) Serial.printf("SSDP::registerWithProxy: Error on beginPacket\n");
+    return SSDP_ERR_UDP;
+  }
+  udp.write((const uint8_t*)txnBuffer,len);
+  if( udp.endPacket() != 1 ) {
+    if( loggingLevel(WARNING) ) Serial.printf("SSDP::registerWithProxy: Error on endPacket attempt to send %d bytes\n",len);
+    return SSDP_ERR_SEND;
   }
+  delay(REGISTER_DELAY);
+  return SSDP_OK;
+}
+
+#endif
+
+/**
+ *  Return true if address is on the network of interface ifc with subnet mask, and the interface is up
+ */
+boolean onNetwork(IPAddress address, IPAddress ifc, IPAddress mask) {
+  uint32_t m = (uint32_t)mask;
+  return ((uint32_t)ifc != 0) && (((uint32_t)address & m) == ((uint32_t)ifc & m));
+}
+
+/**
+ *  The softAP network has its own subnet mask, which WiFi.subnetMask() (the station mask) does not report
+ */
+IPAddress softAPSubnetMask() {
+#ifdef ESP8266
+  struct ip_info info;
+  if( wifi_get_ip_info(SOFTAP_IF,&info) ) return IPAddress(info.netmask.addr);
+  return IPAddress(255,255,255,0);
+#elif defined(ESP32)
+  uint8_t  cidr = WiFi.softAPSubnetCIDR();
+  uint32_t m    = ((cidr == 0)?(0):(0xFFFFFFFFUL << (32 - cidr)));
+  return IPAddress(m >> 24,(m >> 16) & 0xFF,(m >> 8) & 0xFF,m & 0xFF);
+#endif
 }
 
 boolean SSDP::isLocalIP(IPAddress address) {
-  IPAddress local_IP     = WiFi.localIP();
-  IPAddress subnet       = WiFi.subnetMask();
-  uint32_t  localIPMask  = ((uint32_t)local_IP)  & ((uint32_t)subnet);
-  uint32_t  addr         = (uint32_t) address;
-  return((addr&localIPMask)!=0);  
+  return onNetwork(address,WiFi.localIP(),WiFi.subnetMask());
 }
 
 boolean SSDP::isSoftAPIP(IPAddress address) {
-  IPAddress softAP_IP    = WiFi.softAPIP();
-  IPAddress subnet       = WiFi.subnetMask();
-  uint32_t  softAPIPMask = ((uint32_t)softAP_IP) & ((uint32_t)subnet);
-  uint32_t  addr         = (uint32_t) address;
-  return((addr&softAPIPMask)!=0); 
+  return onNetwork(address,WiFi.softAPIP(),softAPSubnetMask());
 }
 
+/**
+ *  If the station and softAP networks overlap, address belongs to the one with the longer subnet mask, and to the 
+ *  station network if the masks are the same length.
+ */
 IPAddress SSDP::interfaceAddress(IPAddress address) {
   IPAddress local_IP     = WiFi.localIP();
+  IPAddress localMask    = WiFi.subnetMask();
   IPAddress softAP_IP    = WiFi.softAPIP();
-  IPAddress subnet       = WiFi.subnetMask();
-  uint32_t  localIPMask  = ((uint32_t)local_IP)  & ((uint32_t)subnet);
-  uint32_t  softAPIPMask = ((uint32_t)softAP_IP) & ((uint32_t)subnet);
-  uint32_t  addr         = (uint32_t) address;
-  if((addr&localIPMask)!=0) return local_IP;
-  else if((addr&softAPIPMask)!=0) return softAP_IP;
+  IPAddress softAPMask   = softAPSubnetMask();
+  boolean   local        = onNetwork(address,local_IP,localMask);
+  boolean   softAP       = onNetwork(address,softAP_IP,softAPMask);
+  if( local && softAP ) {
+    if( __builtin_popcount((uint32_t)softAPMask) > __builtin_popcount((uint32_t)localMask) ) return softAP_IP;
+    return local_IP;
+  }
+  else if( local )  return local_IP;
+  else if( softAP ) return softAP_IP;
   else return INADDR_ANY;
 }
 
+#if SSDP_RESPONDER
+/**
+ *  A unicast request is addressed to the interface it arrived on, so its destination address is the interface address
+ *  and nothing is inferred. A multicast request (and on ESP32, where WiFiUDP does not report the destination, every
+ *  request) is matched to an interface by the subnet of its sender.
+ */
+IPAddress SSDP::arrivalInterface(WiFiUDP& channel, IPAddress remoteAddr) {
+#ifdef ESP8266
+  IPAddress destination = channel.destinationIP();
+  if( ((uint32_t)destination != 0) && (destination != SSDP_MULTICAST) ) return destination;
+#endif
+  return interfaceAddress(remoteAddr);
+}
+#endif
+
 } // End of namespace lsc
@@ -83,7 +83,23 @@
 #define SSDP_H
 
 #include <ctype.h>
+#include "SSDPConfig.h"
+#include "SSDPHeaders.h"
 #include "UPnPBuffer.h"
+#include "SSDPHistogram.h"
+#include "SSDPResponseSet.h"
+#include "SSDPBulkParser.h"
+#include "SearchTarget.h"
+#include "SSDPTypeIndex.h"
+#include "SSDPFilter.h"
+#include "SSDPCompact.h"
+#include "SSDPProxy.h"
+#include "SSDPNodeProvider.h"
+#include "SSDPChangeLog.h"
+#include "SSDPBurst.h"
+#include "SSDPStreamParser.h"
+#include "SSDPTimerWheel.h"
+#include "SSDPHandlerQueue.h"
 
 #ifdef ESP8266
 #include <ESP8266WiFi.h>
@@ -99,8 +115,6 @@
 */
 namespace lsc {
 
-#define LOC_SIZE 32
-
 #ifndef NULL
 #define NULL 0
 #endif
@@ -110,6 +124,7 @@ namespace lsc {
 #endif
 
 #define UDP_PORT   1900                // local UDP port to listen on
+#define SSDP_NO_BUDGET    0            // begin() without a memory budget
 
 typedef enum {
   SSDP_OK = 0,
@@ -118,22 +133,122 @@ typedef enum {
   SSDP_ERR_ST = 3
 } SSDPResult;
 
+/**
+ *  Request classes for response statistics. A uuid search with ssdp:all is counted as SSDP_REQ_UUID.
+ */
+typedef enum {
+  SSDP_REQ_ROOTDEVICE     = 0,       // upnp:rootdevice
+  SSDP_REQ_ROOTDEVICE_ALL = 1,       // upnp:rootdevice with ssdp:all
+  SSDP_REQ_UUID           = 2,       // uuid:device-UUID
+  SSDP_REQ_URN            = 3,       // urn:domain-name:device:deviceType:ver or urn:domain-name:service:serviceType:ver
+  SSDP_REQ_CLASSES        = 4
+} SSDPRequestClass;
+
+/**
+ *  Receive accounting. WiFiUDP does not report datagrams the network stack discards when its receive queue is full,
+ *  so loss is measured where the protocol makes it visible: truncated datagrams, and the records missing from 
+ *  numbered ssdp:all bursts (see SSDPBurst.h).
+ *     received   - Datagrams read
+ *     truncated  - Datagrams read in part, longer than the receive buffer (client) or with headers dropped (responder)
+ *     rejected   - Datagrams that are not requests to the responder (responder only)
+ *     lost       - ssdp:all records missing from their burst when the search timeout expired (searchAllRequest only)
+ *     recovered  - Lost records received on re-request (searchAllRequest only)
+ */
+typedef struct SSDPReceiveStats {
+  uint32_t  received;
+  uint32_t  truncated;
+  uint32_t  rejected;
+  uint32_t  lost;
+  uint32_t  recovered;
+} SSDPReceiveStats;
+
+/**
+ *  Memory held by the responder's optional structures, and which of them are in use. Anything missing falls back to
+ *  the path used without it.
+ *     budget     - Budget passed to begin(), SSDP_NO_BUDGET if none
+ *     used       - Bytes held by the type index, change log and proxy table
+ *     typeIndex  - urn: searches use the type index, otherwise they walk the device tree
+ *     changeLog  - Changes the change log holds, 0 if it is not enabled and sync requests are answered with the whole tree
+ *     proxy      - Proxy table entries, 0 if it is not enabled
+ */
+typedef struct SSDPMemoryReport {
+  size_t    budget;
+  size_t    used;
+  boolean   typeIndex;
+  int       changeLog;
+  int       proxy;
+} SSDPMemoryReport;
+
+/**
+ *  One response of a deferred post, collected when the post starts (see SSDP::continuePost). A sync response has no
+ *  provider; its uuid and type are taken from node and sync holds the SYNC value.
+ */
+typedef struct SSDPPostStep {
+  SSDPNodeProvider*  provider;
+  SSDPNode           node;
+  PGM_P              sync;
+  int                index;                 // Position in burst
+} SSDPPostStep;
+
 typedef std::function<void(UPnPBuffer*)> SSDPHandler;
+typedef std::function<void(const char* packet, int len, IPAddress remoteAddr, int port)> SSDPSendHandler;
+typedef std::function<void(const char* packet, int len, IPAddress remoteAddr)> SSDPPacketHandler;
 
 class SSDP {
 
   public:
   SSDP();
   
-  void         begin(RootDevice* root);                  // RootDevice to handle search requests
+#if SSDP_RESPONDER
+  ~SSDP();
+
+  void         begin(RootDevice* root, size_t budget = SSDP_NO_BUDGET);          // RootDevice to handle search requests
+  void         begin(SSDPNodeProvider* provider, size_t budget = SSDP_NO_BUDGET); // Node provider to handle search requests (see SSDPNodeProvider.h)
   void         doSSDP();                                 // Read both Unicast and Multicast UDP channels and respond accordingly
+  void         rearm();                                  // Rejoin the multicast group and rebind channels after a WiFi reconnect
+  void         reindex();                                // Rebuild search indices after devices or services are added to the RootDevice
   int          getUDPPort();                             // Return unicast UDP channel port
+
+/**
+ *  Memory budget. With a budget (in bytes) passed to begin(), the type index, change log and proxy table are held 
+ *  within it, allocated in the order they are set up: begin() builds the type index first, and enableChangeLog() and
+ *  enableProxy() are given what remains, at a reduced capacity if need be. A structure that does not fit is not 
+ *  allocated and the responder falls back to the path it uses without it. memoryReport() returns the effective 
+ *  configuration, which begin() also logs at INFO.
+ */
+  SSDPMemoryReport memoryReport() const;
+
+/**
+ *  Event loop integration, in place of calling doSSDP() on every loop():
+ *     deferPacing   - If true, responses are paced by deadlines rather than by blocking DELAY milliseconds between
+ *                     packets. One response is sent per onTimer() deadline, and requests wait in their channel 
+ *                     until the responses to the previous request are sent. Responses handed to a send handler
+ *                     are not paced either way.
+ *     nextDeadline  - Milliseconds until onTimer() has work (a timer or a rearm after WiFi reconnect), 0 if it has 
+ *                     work now, SSDP_NO_DEADLINE if it has none. Proxy entries and held bursts expire when they are 
+ *                     next read, so they set no deadline.
+ *     onReadable    - Read and answer the requests waiting in both channels
+ *     onTimer       - Do the timed work that is due
+ *     timers        - The timing wheel driven by onTimer(). Deferred responses are paced by its timers, and a sketch
+ *                     may schedule its own so the single nextDeadline() covers them too.
+ *  WiFiUDP exposes no socket descriptors, so there is nothing to register with select or epoll. Call onReadable() 
+ *  when the network stack has data, or on each wakeup; a sketch can sleep for nextDeadline() milliseconds (or until 
+ *  its own next deadline) since received packets are held by the network stack. doSSDP() is onTimer() followed by
+ *  onReadable() for one request per channel.
+ */
+  void          deferPacing(boolean defer)               {_deferred = defer;}
+  unsigned long nextDeadline();
+  void          onReadable();
+  void          onTimer();
+  SSDPTimerWheel& timers()                               {return _timers;}
+#endif
   int          getMulticastPort();                       // Return Multicast UDP channel port
   
   static boolean   isLocalIP(IPAddress addr);            // Return true if addr is on the localIP network
-  static boolean   isSoftAPIP(IPAddress addr);           // Return true if addr is on the softAPIP network
-  static IPAddress interfaceAddress(IPAddress addr);     // Return the network interface (either local or softAP) of addr
+  static boolean   isSoftAPIP(IPAddress addr);           // Return true if addr is on the softAPIP network (softAP subnet mask)
+  static IPAddress interfaceAddress(IPAddress addr);     // Return the network interface (either local or softAP) of addr, INADDR_ANY if neither
 
+#if SSDP_CLIENT
 /**
  *  Send an SSDP Search request and parse responses for timeout milliseconds.
  *  Each response is handed to an SSDPHandler for processing.
@@ -143,14 +258,149 @@ class SSDP {
  *                 uuid:Device-UUID                              For example - uuid: b2234c12-417f-4e3c-b5d6-4d418143e85d
  *                 urn:domain-name:device:deviceType:ver         For example - urn:LEELANAUSOFTWARE-com:device:SoftwareClock:1
  *                 urn:domain-name:service:serviceType:ver       For example - urn:LEELANAUSOFTWARE-com:service:GetDateTime:1
+ *               A urn: Search Target may be a type pattern where '*' matches any sequence of characters, for example
+ *                 urn:LEELANAUSOFTWARE-com:service:*            Every service in the domain
+ *                 urn:LEELANAUSOFTWARE-com:device:SoftwareClock:* Every version of SoftwareClock
  *     handler - An SSDPHandler function called on each response to the request
  *     ifc     - The network interface to bind the request to (either WiFi.localIP() or WiFi.softAPIP())
  *     timeout - Listen for responses for timeout milliseconds and then return to caller. If ST is uuid:Devce-UUID, processing returns
  *               after the specific device responds or timeout expires, otherwise processing returns after timeout milliseconds.
  *     ssdpAll - Applies only to upnp:rootdevice searches, if true, ALL RootDevices, embedded UPnPDevices, 
  *               and UPnPServices respond, otherwise only RootDevices respond.
+ *     filter  - (Optional) Filter expression evaluated by responders on each device and service, so only matching
+ *               nodes respond. Terms are separated by ';' and must all match (see SSDPFilter.h):
+ *                 name=prefix      Display name starts with prefix
+ *                 service=type     Device hosts a service of type (which may be a pattern), or service is of type
+ *                 depth=n          RootDevice is depth 0, embedded device 1, services one deeper than their device
+ *               For example - SSDP::searchRequest("upnp:rootdevice",handler,WiFi.localIP(),5000,true,"name=Kitchen");
+ */
+  static SSDPResult      searchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout=2000, boolean ssdpAll=false,
+                                       const char* filter=NULL);
+
+/**
+ *  Send an SSDP Search request and collect responses into results rather than handing them to a handler. Each response
+ *  is parsed into an SSDPRecord held in the result set's arena; responses that do not fit are counted in 
+ *  results.dropped(). Records accumulate across searches until results.clear() is called.
+ *  If results.compact() is set, the request asks responders for the compact binary encoding (see SSDPCompact.h), which 
+ *  is decoded straight into records. Responders that do not support it answer in text, which is collected as usual.
+ */
+  static SSDPResult      searchRequest(const char* ST, SSDPResponseSet& results, IPAddress ifc, int timeout=2000, boolean ssdpAll=false,
+                                       const char* filter=NULL);
+
+/**
+ *  Send an SSDP Search request and queue responses for queue's handler rather than calling it from the receive loop.
+ *  Each matching response is copied into the queue (see SSDPHandlerQueue.h) and the handler is run by queue.dispatch(),
+ *  which a sketch calls from loop(). While the channel is empty during the search, one waiting response is dispatched
+ *  per poll, so handlers start before the search returns without delaying responses that have arrived.
+ */
+  static SSDPResult      searchRequest(const char* ST, SSDPHandlerQueue& queue, IPAddress ifc, int timeout=2000, boolean ssdpAll=false,
+                                       const char* filter=NULL);
+
+/**
+ *  Send a compile time SearchTarget (see SearchTarget.h). The M-SEARCH packet is sent from flash without formatting and
+ *  responses are handled as for searchRequest above. ssdp:all is part of the SearchTarget.
+ */
+  static SSDPResult      searchRequest(const SearchTarget& target, SSDPHandler handler, IPAddress ifc, int timeout=2000);
+  static SSDPResult      searchRequest(const SearchTarget& target, SSDPResponseSet& results, IPAddress ifc, int timeout=2000);
+
+/**
+ *  Send an SSDP Search request to a single device at target rather than the multicast group. Parameters and response
+ *  handling are the same as searchRequest.
+ */
+  static SSDPResult      unicastSearchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, IPAddress target, 
+                                              int timeout=2000, boolean ssdpAll=false, const char* filter=NULL);
+
+/**
+ *  Send an ssdp:all search (ST is upnp:rootdevice or uuid:device-UUID) and recover lost responses. Responders number 
+ *  the responses to ssdp:all (see SSDPBurst.h); after timeout, the missing records of each responder are re-requested 
+ *  from it by unicast, up to retries times, so a lost packet costs a few packets rather than another search. handler 
+ *  is called once per record. Compact responses are not numbered and are not recovered.
+ */
+  static SSDPResult      searchAllRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout=2000, const char* filter=NULL,
+                                          int retries=2);
+
+/**
+ *  Bring a mirror of the RootDevice with uuid up to date. generation is the generation the mirror was taken at (0 if
+ *  there is no mirror) and is set to the responder's current generation. If the responder's change log covers 
+ *  generation, handler is called only for devices and services added or changed since, and for removed ones, where 
+ *  UPnPBuffer::isRemoved() is true and only the USN is present. Otherwise the whole tree is sent, full is set, and
+ *  the mirror should be rebuilt from the responses. A responder without a change log always sends the whole tree and
+ *  leaves generation unchanged.
+ */
+  static SSDPResult      syncRequest(const char* uuid, uint32_t& generation, SSDPHandler handler, IPAddress ifc, boolean& full,
+                                     int timeout=2000);
+
+/**
+ *  Receive accounting of the most recent search (any searchRequest, unicastSearchRequest, searchAllRequest or 
+ *  syncRequest), reset when the next search starts. lost - recovered is the number of records that did not arrive.
+ */
+  static const SSDPReceiveStats& searchStats()                    {return _searchStats;}
+#endif
+
+/**
+ *  Replay support for captured traffic. Captured datagrams can be fed through the same code paths used on the network,
+ *  either into this responder or into a search handler, without touching a UDP socket:
+ *     replay         - Process a captured M-SEARCH request as if it arrived from remoteAddr:port. Returns true if 
+ *                      a response was posted.
+ *     replayResponse - Hand a captured search response to handler if it is an LSC response matching ST. Returns true
+ *                      if handler was called.
+ *  Set a send handler to receive rendered responses instead of sending them over UDP. Responses handed to a send
+ *  handler are not paced. Clear the send handler to restore UDP.
  */
-  static SSDPResult      searchRequest(const char* ST, SSDPHandler handler, IPAddress ifc, int timeout=2000, boolean ssdpAll=false);
+#if SSDP_RESPONDER
+  boolean                replay(const char* packet, IPAddress remoteAddr, int port);
+#endif
+#if SSDP_CLIENT
+  static boolean         replayResponse(const char* packet, const char* ST, SSDPHandler handler);
+#endif
+#if SSDP_RESPONDER
+  void                   setSendHandler(SSDPSendHandler handler)  {_sendHandler = handler;}
+  void                   clearSendHandler()                       {_sendHandler = nullptr;}
+
+/**
+ *  Response statistics, all durations in microseconds:
+ *     responseLatency - Time from request arrival until the last response is sent, by request class
+ *     queueWait       - Time from request arrival until the first response starts sending
+ *     sendTime        - Time to send a single response packet, excluding pacing between packets
+ *  Use SSDPHistogram::percentile() to read percentiles, for example ssdp.responseLatency(SSDP_REQ_UUID).percentile(99)
+ */
+  const SSDPHistogram&   responseLatency(SSDPRequestClass c) const;
+  const SSDPHistogram&   queueWait()                         const   {return _queueWait;}
+  const SSDPHistogram&   sendTime()                          const   {return _sendTime;}
+  const SSDPReceiveStats& receiveStats()                     const   {return _received;}   // Requests read on both channels
+  boolean                isPosting()                         const   {return _posting;}    // Deferred responses are being sent
+  void                   resetStats();
+
+/**
+ *  Proxy mode, for devices that deep sleep and would miss search requests. A mains powered responder enables a proxy
+ *  table, and each sleeping device registers its RootDevice with the proxy before it sleeps:
+ *     enableProxy         - Allocate a table of capacity devices and services. Register messages are accepted and 
+ *                           searches are answered for registered nodes, with their own LOCATION, until their TTL expires.
+ *     registerWithProxy   - Send a unicast LSC register message to proxy for root, each embedded device and each 
+ *                           service, valid for ttl seconds (at most PROXY_MAX_TTL). Register again before ttl expires.
+ *     unregisterWithProxy - Remove root (or each root of provider) and everything below it from proxy.
+ *  The register message is a NOTIFY with NTS: lsc:register carrying the headers of a search response, with the
+ *  lifetime in CACHE-CONTROL: max-age, and the device's token in TOKEN.LEELANAUSOFTWARE.COM. Registrations belong to
+ *  the token until they expire, so only the same token can refresh or remove them, from any address. The token 
+ *  defaults to the station MAC address; pass a secret token so that other hosts can not take registrations over.
+ */
+  boolean                enableProxy(int capacity);
+  void                   disableProxy()                           {endPost("proxy table reset"); _proxy.end();}
+  const SSDPProxy&       proxy()                             const   {return _proxy;}
+  static SSDPResult      registerWithProxy(RootDevice* root, IPAddress proxy, int ttl, const char* token = NULL);
+  static SSDPResult      registerWithProxy(SSDPNodeProvider* provider, IPAddress proxy, int ttl, const char* token = NULL);
+  static SSDPResult      unregisterWithProxy(RootDevice* root, IPAddress proxy, const char* token = NULL);
+  static SSDPResult      unregisterWithProxy(SSDPNodeProvider* provider, IPAddress proxy, const char* token = NULL);
+
+/**
+ *  Delta sync. With a change log enabled, each reindex() records the devices and services added, removed or changed
+ *  since the previous reindex() under a new generation, and clients can ask for changes since a generation (see
+ *  syncRequest). The log holds capacity changes, older generations are answered with the whole tree.
+ */
+  boolean                enableChangeLog(int capacity);
+  void                   disableChangeLog()                       {_changes.end();}
+  const SSDPChangeLog&   changeLog()                         const   {return _changes;}
+#endif
 
 /**
  *  Set/Get/Check Logging Level. Logging Level can be NONE, INFO, FINE, and FINEST
@@ -160,22 +410,109 @@ class SSDP {
   static boolean          loggingLevel(LoggingLevel level)        {return(logging() >= level);}
 
   private:
-  RootDevice*                _root;                      // RootDevice to expose through SSDP
+#if SSDP_RESPONDER
+  SSDPRootDeviceProvider     _rootProvider;              // Provider for a RootDevice passed to begin()
+  SSDPNodeProvider*          _provider = NULL;           // Nodes to expose through SSDP
   WiFiUDP                    _mUdp;                      // Multicast Discovery
   WiFiUDP                    _udp;                       // Unicast Discovery and resopnse
+  volatile boolean           _rearm = false;             // Set from WiFi events, rearm on the next doSSDP()
+#ifdef ESP8266
+  WiFiEventHandler           _gotIP;                     // Station got IP (connect, reconnect or DHCP address change)
+#elif defined(ESP32)
+  wifi_event_id_t            _gotIP = 0;
+#endif
+#endif
   static LoggingLevel        _logging;
   
+#if SSDP_RESPONDER
   std::function<void(void)>  _postHandler = []{};
+  SSDPSendHandler            _sendHandler = nullptr;
+
+  SSDPFilter                 _filter;                    // Filter of the request being answered
+  boolean                    _compact = false;           // Request being answered asked for compact responses
+  IPAddress                  _ifc;                       // Interface the request being answered arrived on
+
+  SSDPHistogram              _latency[SSDP_REQ_CLASSES];
+  SSDPHistogram              _queueWait;
+  SSDPHistogram              _sendTime;
+  SSDPReceiveStats           _received     = {0,0,0,0,0};
+  SSDPRequestClass           _requestClass = SSDP_REQ_ROOTDEVICE;   // Class of the request being answered
+  unsigned long              _arrival      = 0;                     // Arrival time of the request being answered
+  unsigned long              _lastSent     = 0;                     // Time the last response was sent
+  int                        _responses    = 0;                     // Responses sent for the request being answered
+  boolean                    _deferred     = false;                 // Pace responses by deadline rather than delay()
+  boolean                    _posting      = false;                 // Deferred responses are being sent
+  boolean                    _planning     = false;                 // Post handler is collecting deferred responses
+  boolean                    _planFailed   = false;                 // Deferred responses did not fit the plan
+  SSDPPostStep*              _plan         = NULL;                  // Deferred responses of the current post
+  int                        _planSize     = 0;
+  int                        _planCap      = 0;
+  int                        _postNext     = 0;                     // Index of the next deferred response
+  const char*                _postST       = NULL;                  // ST, burst and destination of the current post
+  const SSDPBurst*           _postBurst    = NULL;
+  IPAddress                  _postRemote;
+  int                        _postPort     = 0;
+  SSDPTimer                  _postTimer    = SSDP_NO_TIMER;
+  SSDPTimerWheel             _timers;                              // Deferred responses and sketch timers
+
+  SSDPProxy                  _proxy;                     // Nodes registered by sleeping devices
+  SSDPChangeLog              _changes;                   // Topology changes of the provider's nodes
+  SSDPBurstTable             _bursts;                    // Recent ssdp:all bursts, held for re-requests
+  size_t                     _budget = SSDP_NO_BUDGET;   // Memory budget for the index, change log and proxy table
+#endif
+
+#if SSDP_CLIENT
+  static SSDPReceiveStats    _searchStats;               // Receive accounting of the most recent search
 
+  static SSDPResult search(const char* ST, SSDPPacketHandler handler, IPAddress ifc, IPAddress target, int timeout, boolean ssdpAll, 
+                           const char* filter, boolean compact=false, SSDPHandlerQueue* queue=NULL);
+  static SSDPResult exchange(PGM_P packet, SSDPPacketHandler handler, IPAddress ifc, IPAddress target, int timeout,
+                             char buffer[], size_t size, SSDPHandlerQueue* queue=NULL);
+  static void       appendHeader(char buffer[], size_t size, PGM_P packet, PGM_P format, const char* value);
+  static SSDPPacketHandler textHandler(const char* ST, SSDPHandler handler);
+  static SSDPPacketHandler resultsHandler(const char* ST, SSDPResponseSet& results);
+#endif
 
-  void      doChannel(WiFiUDP& channel);                                                          // Check for incoming search requests and respond
+#if SSDP_RESPONDER
+  void      start();                                                                              // Start channels and WiFi event handlers
+  size_t    memoryUsed() const;                                                                   // Bytes held by the index, change log and proxy table
+  size_t    available(size_t held) const;                                                         // Budget left for a structure holding held bytes
+  boolean   doChannel(WiFiUDP& channel);                                                          // Check for an incoming search request and respond, returns true if one was read
   void      setPostHandler(std::function<void(void)> handler) {_postHandler = handler;}           // Set post response handler
   boolean   readChannel(WiFiUDP& channel);                                                        // Read bytes from channel, returns true if response required
-  void      postAllResponse(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port );      // post search response for all embedded devices and services
-  void      postAllMatching(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port );      // post search response for matching devices and services
-  void      postAllReverse(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port );       // post search all response in reverse
-  void      postDeviceResponse(UPnPDevice* d, const char* st, IPAddress remoteAddr, int port );   // post search response for device, returns USN
-  void      postServiceResponse(UPnPService* s, const char* st, IPAddress remoteAddr, int port ); // post search response for service
+  static IPAddress arrivalInterface(WiFiUDP& channel, IPAddress remoteAddr);                      // Interface the request read from channel arrived on
+  boolean   readPacket(const char* packet, IPAddress remoteAddr, int port);                       // Parse a request packet, returns true if response required
+  boolean   compileFilter(UPnPBuffer& buffer);                                                    // Compile the request filter, returns false if malformed
+  boolean   negotiateEncoding(UPnPBuffer& buffer);                                                // Set _compact from the request, returns true if compact
+  void      sendResponse(const char* packet, int len, IPAddress remoteAddr, int port);            // Send (or hand off) a rendered response
+  void      postResponses(unsigned long arrival);                                                 // Run the post handler and record latency
+  void      continuePost();                                                                       // Send the next deferred response
+  void      endPost(const char* reason);                                                          // Abandon the deferred post in progress, if any
+  boolean   plan(SSDPNodeProvider* provider, const SSDPNode& node, PGM_P sync, const char* st, IPAddress remoteAddr, int port,
+                 const SSDPBurst* burst, int index);                                              // Add a response to the plan
+  void      recordLatency();                                                                      // Record latency of the request answered
+  void      forEachProvider(std::function<void(SSDPNodeProvider*)> fn);                          // Call fn on the node provider and the proxy table
+  boolean   nodeMatches(SSDPNodeProvider* provider, const SSDPNode& node);                        // Evaluate the request filter on node
+  void      postRoots(const char* st, boolean all, IPAddress remoteAddr, int port);               // post search response for root devices
+  void      postAllResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port);  // post node and every node below it
+  void      postAllMatching(const char* st, IPAddress remoteAddr, int port );                     // post search response for matching devices and services
+  void      postNodeResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port,
+                             const SSDPBurst* burst=NULL, int index=0);                           // post search response for node
+  void      sendNodeResponse(SSDPNodeProvider* provider, const SSDPNode& node, const char* st, IPAddress remoteAddr, int port,
+                             const SSDPBurst* burst, int index);                                  // render and send response for node
+  void      postBurst(SSDPBurst* burst, const char* missing, IPAddress remoteAddr, int port);     // post a burst, or its missing records
+  void      forEachBurstNode(const SSDPBurst* burst, std::function<void(SSDPNodeProvider*,const SSDPNode&)> fn);  // Records of a burst in order
+  static void walkAll(SSDPNodeProvider* provider, const SSDPNode& node, std::function<void(SSDPNodeProvider*,const SSDPNode&)>& fn);
+  void      readRegister(UPnPBuffer& buffer, IPAddress remoteAddr);                               // Add or remove a proxy registration
+  void      postChanges(const SSDPNode& root, uint32_t since, const char* st, IPAddress remoteAddr, int port);  // post changes to root since generation
+  void      postSyncResponse(const char* st, SSDPRecordKind kind, const char* uuid, const char* type, PGM_P sync, IPAddress remoteAddr, int port);
+  void      sendSyncResponse(const char* st, SSDPRecordKind kind, const char* uuid, const char* type, PGM_P sync, IPAddress remoteAddr, int port);
+  boolean   findNode(SSDPRecordKind kind, const char* uuid, const char* type, SSDPNode& node);  // Find a device or service of the provider
+  static SSDPResult registerNode(WiFiUDP& udp, SSDPNodeProvider* provider, const SSDPNode& node, IPAddress proxy, IPAddress ifc, int ttl,
+                                  const char* token);
+  static SSDPResult sendRegister(WiFiUDP& udp, SSDPNodeProvider* provider, const SSDPNode& node, IPAddress proxy, IPAddress ifc, int ttl,
+                                  const char* token);
+#endif
 
 };
 